@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "lcycle/ReplayFile.hpp"
+#include "lcycle/World.hpp"
+
+namespace bench {
+
+/*! Folded into by benchmarks so the optimizer can't drop the measured work. */
+inline volatile uint64_t sink = 0;
+
+/*! Runs f `runs` times and returns the mean wall time of one run in nanoseconds. */
+template <typename F>
+double nsPerRun(int runs, F&& f) {
+    using clock = std::chrono::steady_clock;
+    f();  // warm up caches and lazily grown buffers
+    auto start = clock::now();
+    for (int i = 0; i < runs; i++) f();
+    std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+    return elapsed.count() / runs;
+}
+
+inline void report(const char* name, double ns, double perItems = 1.0) {
+    std::printf("%-40s %12.1f ns  %10.3f ns/item\n", name, ns, ns / perItems);
+}
+
+/*! n players spread evenly on a circle around the middle of the arena, heading outwards. */
+inline std::vector<lcycle::Player> circleOfPlayers(int n, float radius = 3.0f) {
+    std::vector<lcycle::Player> players;
+    for (int i = 0; i < n; i++) {
+        double angle = 2 * M_PI * i / n;
+        lcycle::Cycle c({(float)(radius * cos(angle)), (float)(radius * sin(angle))}, angle);
+        players.push_back({c, i, "", {}, {}});
+    }
+    return players;
+}
+
+/*!
+ * n players on a square lattice `spacing` apart, centred on the origin, with
+ * headings spread by the golden angle. Returns the arena size that fits them
+ * with one spacing of border.
+ */
+inline double latticeOfPlayers(int n, float spacing, std::vector<lcycle::Player>& players) {
+    const int side = (int)std::ceil(std::sqrt((double)n));
+    const float offset = (side - 1) * spacing / 2;
+    players.clear();
+    for (int i = 0; i < n; i++) {
+        double angle = i * M_PI * (3.0 - std::sqrt(5.0));
+        lcycle::Cycle c({i % side * spacing - offset, i / side * spacing - offset}, angle);
+        players.push_back({c, i, "", {}, {}});
+    }
+    return (side + 1) * spacing;
+}
+
+/*! Deterministic pseudo-random steering: every tick each player has a small chance of changing direction. */
+class ScriptedInputs {
+   public:
+    ScriptedInputs(int nPlayers, uint32_t seed) : _rng(seed + 1) {
+        for (int i = 0; i < nPlayers; i++) _inputs.push_back({i, {0.0f}});
+    }
+
+    const lcycle::World::PlayerInputs& next() {
+        for (auto& input : _inputs) {
+            _rng = _rng * 1664525u + 1013904223u;
+            if ((_rng >> 24) < 8) input.second.turnDir = (int)(_rng >> 8) % 3 - 1;
+        }
+        return _inputs;
+    }
+
+   private:
+    lcycle::World::PlayerInputs _inputs;
+    uint32_t _rng;
+};
+
+/*!
+ * Steering that keeps matches going for minutes: every player turns away
+ * from a wall it's heading for and otherwise now and then at random. inputs
+ * has to hold the players by id, starting from 0.
+ */
+inline void wander(const lcycle::World& w, uint32_t& rng, lcycle::World::PlayerInputs& inputs) {
+    const float edge = (float)w.size() / 2 - 15.0f;
+    for (auto& input : inputs) input.second.turnDir = 0.0f;
+    for (const auto& p : w.players()) {
+        const auto pos = p.cycle.pos();
+        const auto heading = p.cycle.heading();
+        const bool leaving = (pos.x() > edge && heading.x() > 0) || (pos.x() < -edge && heading.x() < 0) ||
+                             (pos.y() > edge && heading.y() > 0) || (pos.y() < -edge && heading.y() < 0);
+        rng = rng * 1664525u + 1013904223u;
+        float turn = (rng >> 24) < 6 ? ((rng >> 8) & 1 ? 1.0f : -1.0f) : 0.0f;
+        inputs[p.id].second.turnDir = leaving ? 1.0f : turn;
+    }
+}
+
+/*!
+ * Plays a match of wandering bots the way the game does, in a fixed point
+ * arena of size `arena` until at most one player is left or maxFrames are up,
+ * recording it to a replay file at path. Returns the id of the winner, or -1.
+ */
+inline int recordMatch(const std::string& path, int players, double arena, uint32_t seed, size_t maxFrames) {
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+    lcycle::World w(arena, 0.14, circleOfPlayers(players, (float)arena / 8), lcycle::Kinematics::Fixed);
+    lcycle::ReplayWriter writer(path, w, kTimePerFrame, 60, 600);
+    lcycle::World::PlayerInputs inputs;
+    for (int i = 0; i < players; i++) inputs.push_back({i, {0.0f}});
+    while (writer.frames() < maxFrames && w.players().size() > 1) {
+        wander(w, seed, inputs);
+        w.runFor(kTimePerFrame, inputs);
+        writer.record(inputs, w);
+    }
+    writer.close();
+    return w.players().size() == 1 ? w.players()[0].id : -1;
+}
+
+}  // namespace bench
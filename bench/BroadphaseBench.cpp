@@ -0,0 +1,38 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+
+// Time per tick as the arena grows from 2 to 1024 players at a constant
+// density, to show cycle-cycle checks scaling close to linearly.
+int main() {
+    using namespace lcycle;
+
+    constexpr int kTicks = 600;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    std::printf("%8s %10s %10s %14s %18s\n", "players", "ticks", "survivors", "us/tick", "ns/player-tick");
+    for (int nPlayers = 2; nPlayers <= 1024; nPlayers *= 2) {
+        std::vector<Player> players;
+        double size = bench::latticeOfPlayers(nPlayers, 6.0f, players);
+        World w(size, 0.14, players);
+        w.reserve(1024);
+        bench::ScriptedInputs inputs(nPlayers, nPlayers);
+
+        uint64_t ticks = 0;
+        uint64_t playerTicks = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (; ticks < kTicks && w.players().size() > 1; ticks++) {
+            playerTicks += w.players().size();
+            w.runFor(kTimePerFrame, inputs.next());
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%8d %10llu %10zu %14.2f %18.1f\n", nPlayers, (unsigned long long)ticks, w.players().size(),
+                    ns / ticks / 1000.0, ns / playerTicks);
+    }
+    return 0;
+}
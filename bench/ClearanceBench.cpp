@@ -0,0 +1,43 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+
+// Reports how many per-cycle collision checks World::runFor skips thanks to
+// clearance certificates, across scripted matches of growing player counts.
+int main() {
+    using namespace lcycle;
+
+    constexpr int kGames = 100;
+    constexpr int kMaxTicks = 20000;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    std::printf("%8s %10s %10s %10s %14s\n", "players", "ticks", "checked", "skipped", "ticks/sec");
+    for (int nPlayers : {2, 4, 8, 16, 32}) {
+        uint64_t ticks = 0;
+        CollisionStats total;
+        double secs = 0.0;
+
+        for (int game = 0; game < kGames; game++) {
+            World w(50.0, 0.14, bench::circleOfPlayers(nPlayers, 8.0f));
+            bench::ScriptedInputs inputs(nPlayers, game);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int tick = 0; tick < kMaxTicks && w.players().size() > 1; tick++) {
+                w.runFor(kTimePerFrame, inputs.next());
+                ticks++;
+            }
+            secs += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            total.checked += w.collisionStats().checked;
+            total.skipped += w.collisionStats().skipped;
+        }
+
+        double skipped = (double)total.skipped / (total.checked + total.skipped);
+        std::printf("%8d %10llu %10llu %9.1f%% %14.0f\n", nPlayers, (unsigned long long)ticks,
+                    (unsigned long long)total.checked, 100.0 * skipped, ticks / secs);
+    }
+    return 0;
+}
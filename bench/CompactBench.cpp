@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+
+// Plays the same scripted matches with and without World::compact every
+// second of play, and reports how many trail primitives are left, how long
+// ticks and world copies take, and whether the matches end the same way.
+
+namespace {
+
+struct Result {
+    std::vector<int> deaths;
+    uint64_t ticks = 0;
+    uint64_t segments = 0;
+    uint64_t runs = 0;
+    uint64_t dashes = 0;
+    double tickNs = 0.0;
+    double copyNs = 0.0;
+};
+
+Result play(int nPlayers, uint32_t seed, bool compact) {
+    using namespace lcycle;
+
+    constexpr int kMaxTicks = 20000;
+    constexpr int kCompactEvery = 60;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    World w(50.0, 0.14, bench::circleOfPlayers(nPlayers, 8.0f));
+    bench::ScriptedInputs inputs(nPlayers, seed);
+    Result r;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < kMaxTicks && w.players().size() > 1; tick++) {
+        const size_t alive = w.players().size();
+        std::vector<bool> wasAlive(nPlayers, false);
+        for (const auto& p : w.players()) wasAlive[p.id] = true;
+
+        w.runFor(kTimePerFrame, inputs.next());
+        if (compact && tick % kCompactEvery == kCompactEvery - 1) w.compact();
+        r.ticks++;
+
+        if (w.players().size() != alive) {
+            for (const auto& p : w.players()) wasAlive[p.id] = false;
+            for (int id = 0; id < nPlayers; id++) {
+                if (wasAlive[id]) r.deaths.push_back(id);
+            }
+        }
+    }
+    r.tickNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / r.ticks;
+
+    for (const auto& trail : w.trails()) {
+        r.segments += trail.size();
+        r.runs += trail.runs().size();
+        for (const auto& run : trail.runs()) r.dashes += run.count;
+    }
+    r.copyNs = bench::nsPerRun(200, [&]() {
+        World copy = w;
+        bench::sink += copy.trails().size();
+    });
+    return r;
+}
+
+}  // namespace
+
+int main() {
+    constexpr int kGames = 50;
+
+    std::printf("%8s %12s %12s %10s %12s %12s %12s %12s %8s\n", "players", "prims", "compacted", "runs",
+                "ns/tick", "ns/tick(c)", "ns/copy", "ns/copy(c)", "same");
+    for (int nPlayers : {2, 4, 8}) {
+        uint64_t prims = 0, compactPrims = 0, runs = 0, same = 0;
+        double tickNs = 0.0, compactTickNs = 0.0, copyNs = 0.0, compactCopyNs = 0.0;
+
+        for (int game = 0; game < kGames; game++) {
+            Result plain = play(nPlayers, game, false);
+            Result compacted = play(nPlayers, game, true);
+
+            prims += plain.segments;
+            compactPrims += compacted.segments + compacted.runs;
+            runs += compacted.runs;
+            tickNs += plain.tickNs;
+            compactTickNs += compacted.tickNs;
+            copyNs += plain.copyNs;
+            compactCopyNs += compacted.copyNs;
+            same += plain.deaths == compacted.deaths;
+        }
+
+        std::printf("%8d %12llu %12llu %10llu %12.1f %12.1f %12.1f %12.1f %7llu%%\n", nPlayers,
+                    (unsigned long long)prims, (unsigned long long)compactPrims, (unsigned long long)runs,
+                    tickNs / kGames, compactTickNs / kGames, copyNs / kGames, compactCopyNs / kGames,
+                    (unsigned long long)(100 * same / kGames));
+    }
+    return 0;
+}
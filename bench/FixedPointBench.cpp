@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+
+// Plays the same scripted matches with floating and fixed point kinematics,
+// timing ticks and folding every fixed point match's final state hash into
+// one digest. Builds with different compilers, flags or libms should print
+// the same digest; the float one is only there for comparison.
+
+namespace {
+
+struct Result {
+    uint64_t ticks = 0;
+    double ns = 0.0;
+    uint64_t digest = 0;
+};
+
+Result play(int nPlayers, int games, lcycle::Kinematics kinematics) {
+    using namespace lcycle;
+
+    constexpr int kMaxTicks = 20000;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    Result r;
+    for (int game = 0; game < games; game++) {
+        World w(50.0, 0.14, bench::circleOfPlayers(nPlayers, 8.0f), kinematics);
+        bench::ScriptedInputs inputs(nPlayers, game);
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < kMaxTicks && w.players().size() > 1; tick++) {
+            w.runFor(kTimePerFrame, inputs.next());
+            r.ticks++;
+        }
+        r.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        r.digest = r.digest * 0x100000001b3ull ^ w.stateHash();
+    }
+    return r;
+}
+
+}  // namespace
+
+int main() {
+    using namespace lcycle;
+
+    constexpr int kGames = 50;
+
+    std::printf("%8s %12s %12s %12s %12s %18s\n", "players", "ticks", "ticks(fx)", "ns/tick", "ns/tick(fx)",
+                "digest(fx)");
+    for (int nPlayers : {2, 4, 8, 16}) {
+        Result flt = play(nPlayers, kGames, Kinematics::Float);
+        Result fxd = play(nPlayers, kGames, Kinematics::Fixed);
+        std::printf("%8d %12llu %12llu %12.1f %12.1f %18llx\n", nPlayers, (unsigned long long)flt.ticks,
+                    (unsigned long long)fxd.ticks, flt.ns / flt.ticks, fxd.ns / fxd.ticks,
+                    (unsigned long long)fxd.digest);
+    }
+    return 0;
+}
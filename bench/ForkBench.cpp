@@ -0,0 +1,49 @@
+#include <cstdint>
+#include <cstdio>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+
+// Forks a world the way bots exploring futures do, copying it and playing a
+// few ticks on the copy, as its trails grow. With copy on write trails and
+// grid, forking shouldn't get slower as the match goes on. Fails if any
+// timing was taken on a world, or a fork, that someone had died in.
+int main() {
+    using namespace lcycle;
+
+    constexpr int kPlayers = 4;
+    constexpr int kForkTicks = 10;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    // big enough for cycles to go straight all through the match and every
+    // fork of it without hitting a wall
+    World w(800.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    const PlayerInputs straight = {{0, {0.0f}}, {1, {0.0f}}, {2, {0.0f}}, {3, {0.0f}}};
+
+    std::printf("%10s %14s %20s\n", "segments", "ns/copy", "ns/fork+10 ticks");
+    uint64_t stale = 0;
+    for (int tick = 1; tick <= 2048; tick++) {
+        w.runFor(kTimePerFrame, straight);
+        if ((tick & (tick - 1)) != 0 || tick < 16) continue;
+
+        // timings of a world someone's died in don't count, and forks play on
+        World ahead = w;
+        for (int i = 0; i < kForkTicks; i++) ahead.runFor(kTimePerFrame, straight);
+        stale += ahead.players().size() != kPlayers;
+
+        size_t segments = 0;
+        for (const auto& trail : w.trails()) segments += trail.size();
+        double copyNs = bench::nsPerRun(1000, [&]() {
+            World copy = w;
+            bench::sink += copy.players().size();
+        });
+        double forkNs = bench::nsPerRun(1000, [&]() {
+            World fork = w;
+            for (int i = 0; i < kForkTicks; i++) fork.runFor(kTimePerFrame, straight);
+            bench::sink += fork.players().size();
+        });
+        std::printf("%10zu %14.1f %20.1f\n", segments, copyNs, forkNs);
+    }
+    std::printf("%llu timings with players dead\n", (unsigned long long)stale);
+    return stale == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/InputLog.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/World.hpp"
+
+// Records an hour of scripted inputs for four players both as a vector of
+// every frame's PlayerInputs and in an InputLog, and compares what they take
+// up and how long recording and reading back takes. Checks every frame reads
+// back as recorded, counting allocations while it does, and that a replay
+// recorded through the log plays the match it recorded, including one whose
+// frames only have inputs for some of the players.
+
+namespace {
+
+bool counting = false;
+uint64_t allocations = 0;
+
+void* allocate(size_t size, size_t align) {
+    if (counting) allocations++;
+    // over-allocate and stash the pointer malloc gave us just below the block
+    void* raw = std::malloc(size + align + sizeof(void*));
+    if (!raw) throw std::bad_alloc();
+    uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(uintptr_t)(align - 1);
+    reinterpret_cast<void**>(p)[-1] = raw;
+    return reinterpret_cast<void*>(p);
+}
+
+void release(void* p) {
+    if (p) std::free(reinterpret_cast<void**>(p)[-1]);
+}
+
+bool same(const lcycle::PlayerInputs& a, const lcycle::PlayerInputs& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].first != b[i].first || a[i].second.turnDir != b[i].second.turnDir) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t align) { return allocate(size, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align) { return allocate(size, (size_t)align); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { release(p); }
+
+int main() {
+    using namespace lcycle;
+    using clock = std::chrono::steady_clock;
+
+    constexpr int kPlayers = 4;
+    constexpr size_t kFrames = 60 * 60 * 60;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    std::vector<PlayerInputs> frames;
+    {
+        bench::ScriptedInputs script(kPlayers, 7);
+        for (size_t f = 0; f < kFrames; f++) frames.push_back(script.next());
+    }
+    auto ms = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    std::vector<PlayerInputs> vec;
+    auto t0 = clock::now();
+    for (const auto& inputs : frames) vec.push_back(inputs);
+    auto t1 = clock::now();
+    size_t vecBytes = vec.capacity() * sizeof(PlayerInputs);
+    for (const auto& inputs : vec) vecBytes += inputs.capacity() * sizeof(inputs[0]);
+
+    InputLog log({0, 1, 2, 3});
+    auto t2 = clock::now();
+    for (const auto& inputs : frames) log.push(inputs);
+    auto t3 = clock::now();
+
+    std::printf("%zu frames of %d players\n", kFrames, kPlayers);
+    std::printf("vector:   %10zu bytes %8.1f ns/frame recording\n", vecBytes, 1e6 * ms(t0, t1) / kFrames);
+    std::printf("InputLog: %10zu bytes %8.1f ns/frame recording, %zu runs, %.1fx smaller\n", log.bytes(),
+                1e6 * ms(t2, t3) / kFrames, log.runs(), (double)vecBytes / log.bytes());
+
+    // every frame in order, then at random, none of which should allocate
+    uint64_t wrong = 0;
+    PlayerInputs out;
+    out.reserve(kPlayers);
+    counting = true;
+    auto t4 = clock::now();
+    for (size_t f = 0; f < kFrames; f++) {
+        log.read(f, out);
+        wrong += !same(out, frames[f]);
+    }
+    auto t5 = clock::now();
+    uint32_t rng = 1;
+    double randomNs = bench::nsPerRun(100000, [&]() {
+        rng = rng * 1664525u + 1013904223u;
+        const size_t f = (rng >> 4) % kFrames;
+        log.read(f, out);
+        bench::sink += (uint64_t)(out[f % kPlayers].second.turnDir + 1.0f);
+    });
+    counting = false;
+    std::printf("read: %.1f ns/frame in order, %.1f ns at random, %llu allocations\n", 1e6 * ms(t4, t5) / kFrames,
+                randomNs, (unsigned long long)allocations);
+
+    // what a replay recorded through the log ends up at, against the match
+    const World initial(400.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    Replay replay(initial, kTimePerFrame);
+    World live = initial;
+    size_t played = 0;
+    while (played < kFrames && !live.players().empty()) {
+        replay.record(frames[played]);
+        live.runFor(kTimePerFrame, frames[played++]);
+    }
+    World replayed;
+    replay.seek(played, replayed);
+    wrong += replayed.stateHash() != live.stateHash();
+    std::printf("replay of %zu frames %s the match\n", played,
+                replayed.stateHash() == live.stateHash() ? "matches" : "doesn't match");
+
+    // a frame with inputs for some players only leaves the rest where they
+    // are, and the replay has to as well
+    Replay partial(initial, kTimePerFrame);
+    live = initial;
+    const PlayerInputs first = {{0, {1.0f}}};
+    for (int f = 0; f < 30; f++) {
+        partial.record(first);
+        live.runFor(kTimePerFrame, first);
+    }
+    partial.seek(30, replayed);
+    wrong += replayed.stateHash() != live.stateHash();
+    std::printf("replay of frames with one player's inputs %s the match\n",
+                replayed.stateHash() == live.stateHash() ? "matches" : "doesn't match");
+
+    std::printf("%llu wrong frames\n", (unsigned long long)wrong);
+    return wrong == 0 && allocations == 0 ? 0 : 1;
+}
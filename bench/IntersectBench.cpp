@@ -0,0 +1,71 @@
+#include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <vectorial/config.h>
+
+#include "Bench.hpp"
+#include "lcycle/Line.hpp"
+#include "lcycle/SegmentBatch.hpp"
+
+// Compares the scalar Line::intersect loop with the batched simd4f kernel on
+// the same set of random segments.
+int main() {
+    using namespace lcycle;
+
+    constexpr size_t kSegments = 4096;
+    constexpr size_t kLines = 64;
+    constexpr int kRuns = 200;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-25.0f, 25.0f);
+    std::uniform_real_distribution<float> off(-2.0f, 2.0f);
+    auto randomLine = [&]() {
+        mathfu::vec2 s(pos(rng), pos(rng));
+        return Line(s, s + mathfu::vec2(off(rng), off(rng)));
+    };
+
+    std::vector<Line> segments;
+    SegmentBatch batch;
+    for (size_t i = 0; i < kSegments; i++) {
+        segments.push_back(randomLine());
+        batch.push(segments.back());
+    }
+    std::vector<Line> lines;
+    for (size_t i = 0; i < kLines; i++) lines.push_back(randomLine());
+
+    std::vector<uint32_t> mask((kSegments + 31) / 32);
+
+    size_t mismatches = 0;
+    for (const auto& line : lines) {
+        batch.intersect(line, mask.data());
+        for (size_t i = 0; i < kSegments; i++) {
+            bool simd = (mask[i / 32] >> (i % 32)) & 1;
+            if (simd != Line::intersect(line, segments[i])) mismatches++;
+        }
+    }
+
+    double scalar = bench::nsPerRun(kRuns, [&]() {
+        uint64_t hits = 0;
+        for (const auto& line : lines) {
+            for (const auto& seg : segments) hits += Line::intersect(line, seg);
+        }
+        bench::sink += hits;
+    });
+    double simd = bench::nsPerRun(kRuns, [&]() {
+        uint64_t hits = 0;
+        for (const auto& line : lines) {
+            batch.intersect(line, mask.data());
+            for (auto word : mask) hits += std::bitset<32>(word).count();
+        }
+        bench::sink += hits;
+    });
+
+    std::printf("%zu lines x %zu segments (%s)\n", kLines, kSegments, VECTORIAL_SIMD_TYPE);
+    bench::report("scalar Line::intersect", scalar, kLines * kSegments);
+    bench::report("simd4f intersectMask", simd, kLines * kSegments);
+    std::printf("speedup %.2fx, %zu mismatching results\n", scalar / simd, mismatches);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/World.hpp"
+
+// Records a long match between bots that wander about and keep off the
+// walls, along with the state hash of every frame, then seeks to 90% of the
+// way through it: once cold, with no keyframes yet, and again once playing
+// has made them. Times random seeks, playing forward and playing in reverse
+// through a cursor, and checks every world they produce against the hash
+// recorded for its frame.
+
+int main() {
+    using namespace lcycle;
+    using clock = std::chrono::steady_clock;
+
+    constexpr int kPlayers = 4;
+    constexpr size_t kMaxFrames = 10 * 60 * 60;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    const World initial(400.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    Replay replay(initial, kTimePerFrame);
+    std::vector<uint64_t> hashes;
+    {
+        World w = initial;
+        PlayerInputs inputs;
+        for (int i = 0; i < kPlayers; i++) inputs.push_back({i, {0.0f}});
+        uint32_t rng = 4;
+        hashes.push_back(w.stateHash());
+        while (replay.frames() < kMaxFrames && !w.players().empty()) {
+            bench::wander(w, rng, inputs);
+            replay.record(inputs);
+            w.runFor(kTimePerFrame, inputs);
+            hashes.push_back(w.stateHash());
+        }
+        size_t segments = 0;
+        for (const auto& trail : w.trails()) segments += trail.size();
+        std::printf("%zu frames, %zu segments\n", replay.frames(), segments);
+    }
+    const size_t frames = replay.frames();
+
+    uint64_t wrong = 0;
+    auto ms = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    // first without keyframes, which makes them on the way, then with
+    World w;
+    const size_t late = frames * 9 / 10;
+    auto t0 = clock::now();
+    replay.seek(late, w);
+    auto t1 = clock::now();
+    replay.seek(late, w);
+    auto t2 = clock::now();
+    wrong += w.stateHash() != hashes[late];
+    std::printf("seek to frame %zu: %.3f ms cold, %.3f ms with %zu keyframes\n", late, ms(t0, t1), ms(t1, t2),
+                replay.keyframes());
+
+    // make the rest of the keyframes, then seek all over
+    replay.seek(frames, w);
+    uint32_t rng = 1;
+    double seekNs = bench::nsPerRun(1000, [&]() {
+        rng = rng * 1664525u + 1013904223u;
+        const size_t frame = (rng >> 8) % (frames + 1);
+        replay.seek(frame, w);
+        wrong += w.stateHash() != hashes[frame];
+    });
+    std::printf("random seek: %.1f ns\n", seekNs);
+
+    // the middle half forward through a cursor, then back from where it ended
+    for (int ring : {1, 15, 60, 240}) {
+        ReplayCursor cursor(replay, ring);
+        const size_t from = frames / 4, to = frames * 3 / 4;
+        auto start = clock::now();
+        for (size_t f = from; f <= to; f++) wrong += cursor.at(f).stateHash() != hashes[f];
+        auto forward = clock::now();
+        for (size_t f = to + 1; f-- > from;) wrong += cursor.at(f).stateHash() != hashes[f];
+        auto back = clock::now();
+        std::printf("ring of %3d: %10.1f ns/frame forward %10.1f ns/frame in reverse\n", ring,
+                    1e6 * ms(start, forward) / (to - from + 1), 1e6 * ms(forward, back) / (to - from + 1));
+    }
+
+    std::printf("%llu wrong frames\n", (unsigned long long)wrong);
+    return wrong == 0 ? 0 : 1;
+}
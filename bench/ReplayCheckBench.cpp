@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/ReplayCheck.hpp"
+#include "lcycle/ReplayFile.hpp"
+#include "lcycle/World.hpp"
+#include "util/WorkerPool.hpp"
+
+// Records a corpus of minute long matches between wandering bots,
+// half with two players and half with four, then reads and plays every one
+// through again on all cores the way lcycles-verify does. Checks each finds
+// the winner it was recorded with and matches all its checksums, and that a
+// replay recorded with hashes from a different world doesn't.
+
+int main() {
+    using namespace lcycle;
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+
+    constexpr int kReplays = 200;
+    constexpr double kArena = 200.0;
+    constexpr size_t kMaxFrames = 2 * 60 * 60;
+    const fs::path dir = "ReplayCheckBench.d";
+
+    fs::create_directories(dir);
+    std::vector<std::string> paths;
+    std::vector<int> winners;
+    for (int i = 0; i < kReplays; i++) {
+        paths.push_back((dir / ("match" + std::to_string(i) + ".lcr")).string());
+        winners.push_back(bench::recordMatch(paths.back(), i % 2 == 0 ? 2 : 4, kArena, i, kMaxFrames));
+    }
+
+    // recorded with the hashes of a world that moves its cycles differently
+    const std::string drifted = (dir / "drifted.lcr").string();
+    {
+        const auto players = bench::circleOfPlayers(2, 6.0f);
+        World w(kArena, 0.14, players, Kinematics::Fixed);
+        World other(kArena, 0.14, players, Kinematics::Float);
+        ReplayWriter writer(drifted, w);
+        PlayerInputs inputs = {{0, {1.0f}}, {1, {0.0f}}};
+        for (int f = 0; f < 600; f++) {
+            w.runFor(1.0 / 60.0, inputs);
+            other.runFor(1.0 / 60.0, inputs);
+            writer.record(inputs, other);
+        }
+    }
+
+    util::WorkerPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+    std::vector<ReplayCheck> checks(kReplays);
+    auto start = clock::now();
+    pool.forEach(kReplays, [&](size_t i, int) {
+        ReplayFileInfo info;
+        const Replay replay = readReplay<0>(paths[i], &info);
+        checks[i] = checkReplay(replay, info.checksums);
+    });
+    const double secs = std::chrono::duration<double>(clock::now() - start).count();
+
+    uint64_t wrong = 0, ticks = 0, checksums = 0;
+    for (int i = 0; i < kReplays; i++) {
+        wrong += checks[i].mismatches > 0 || checks[i].winner != winners[i];
+        ticks += checks[i].frames;
+        checksums += checks[i].checksums;
+    }
+    ReplayFileInfo info;
+    const Replay replay = readReplay<0>(drifted, &info);
+    const ReplayCheck check = checkReplay(replay, info.checksums);
+    wrong += check.mismatches == 0;
+
+    std::printf("%d replays, %llu ticks, %llu checksums on %d threads\n", kReplays, (unsigned long long)ticks,
+                (unsigned long long)checksums, pool.threads());
+    std::printf("%.3f s: %.0f ticks/sec, %.0f replays/hour\n", secs, ticks / secs, kReplays / secs * 3600);
+    std::printf("drifted replay: %zu/%zu checksums mismatched from tick %zu\n", check.mismatches, check.checksums,
+                check.firstMismatch);
+
+    fs::remove_all(dir);
+    std::printf("%llu wrong\n", (unsigned long long)wrong);
+    return wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/ReplayFile.hpp"
+#include "lcycle/World.hpp"
+#include "util/MappedFile.hpp"
+
+// Streams a long match between wandering bots to a replay file, rolling it
+// back once on the way, and times what recording costs the game loop. Reads
+// the file back, checks it plays the match it recorded, then cuts it short at
+// random points and flips a byte in it, checking that every damaged copy
+// still plays up to its last intact chunk, and that one with a byte of its
+// header or roster flipped isn't read at all.
+
+int main() {
+    using namespace lcycle;
+    using clock = std::chrono::steady_clock;
+
+    constexpr int kPlayers = 4;
+    constexpr size_t kMaxFrames = 10 * 60 * 60;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+    constexpr int kChunkFrames = 60;
+    constexpr int kKeyframeInterval = 600;
+    constexpr size_t kRollbackAt = 3000, kRollbackTo = 2970;
+    const char* path = "ReplayFileBench.lcr";
+
+    const World initial(400.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    std::vector<uint64_t> hashes;
+    double recordNs = 0.0, worstNs = 0.0;
+    {
+        ReplayWriter writer(path, initial, kTimePerFrame, kChunkFrames, kKeyframeInterval);
+        World w = initial;
+        World rolledBack;
+        PlayerInputs inputs;
+        for (int i = 0; i < kPlayers; i++) inputs.push_back({i, {0.0f}});
+        uint32_t rng = 4;
+        bool rolled = false;
+        hashes.push_back(w.stateHash());
+        while (writer.frames() < kMaxFrames && !w.players().empty()) {
+            bench::wander(w, rng, inputs);
+            w.runFor(kTimePerFrame, inputs);
+            auto start = clock::now();
+            writer.record(inputs, w);
+            const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            recordNs += ns;
+            worstNs = std::max(worstNs, ns);
+            hashes.push_back(w.stateHash());
+
+            if (writer.frames() == kRollbackTo) rolledBack = w;
+            if (writer.frames() == kRollbackAt && !rolled) {
+                // play the frames since differently, as a late input would
+                writer.truncate(kRollbackTo);
+                hashes.resize(kRollbackTo + 1);
+                w = rolledBack;
+                rng += 99;
+                rolled = true;
+            }
+        }
+        writer.close();
+    }
+    const size_t frames = hashes.size() - 1;
+    std::printf("%zu frames, record: %.1f ns/frame, %.1f us at worst\n", frames, recordNs / frames, worstNs / 1e3);
+
+    uint64_t wrong = 0;
+    util::MappedFile file(path);
+    ReplayFileInfo info;
+    auto t0 = clock::now();
+    Replay replay = readReplay<0>(path, &info);
+    auto t1 = clock::now();
+    std::printf("%zu bytes, %zu chunks, %zu keyframes, read in %.3f ms\n", file.size(), info.chunks,
+                replay.keyframes(), std::chrono::duration<double, std::milli>(t1 - t0).count());
+    wrong += replay.frames() != frames || info.truncated;
+    for (const auto& c : info.checksums) wrong += c.first > frames || c.second != hashes[c.first];
+    World w;
+    for (size_t f = 0; f <= frames; f += 97) {
+        replay.seek(f, w);
+        wrong += w.stateHash() != hashes[f];
+    }
+    replay.seek(frames, w);
+    wrong += w.stateHash() != hashes[frames];
+
+    // copies of the file cut short, or with a byte flipped, must play up to
+    // the last chunk before the damage and agree with its checksum
+    std::vector<uint64_t> copy((file.size() + 7) / 8);
+    std::memcpy(copy.data(), file.data(), file.size());
+    uint32_t rng = 1;
+    size_t damaged = 0, lost = 0;
+    for (int i = 0; i < 200; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        const size_t at = file.size() / 2 + (rng >> 8) % (file.size() / 2);
+        const bool flip = i % 2 == 1;
+        auto* bytes = reinterpret_cast<unsigned char*>(copy.data());
+        if (flip) bytes[at] ^= 0x10;
+        ReplayFileInfo cut;
+        Replay r = readReplay<0>(copy.data(), flip ? file.size() : at, &cut);
+        if (flip) bytes[at] ^= 0x10;
+
+        damaged++;
+        lost += frames - std::min(frames, r.frames());
+        r.seek(r.frames(), w);
+        wrong += !cut.truncated || cut.checksums.empty() || cut.checksums.back().first != r.frames() ||
+                 cut.checksums.back().second != w.stateHash();
+    }
+    std::printf("%zu damaged copies, %.1f frames lost on average\n", damaged, (double)lost / damaged);
+
+    // while a byte flipped anywhere in the header or roster refuses the file
+    ReplayFile::Header h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    const size_t rosterEnd = sizeof(h) + h.players * sizeof(ReplayFile::PlayerEntry);
+    size_t accepted = 0;
+    for (size_t at = 0; at < rosterEnd; at++) {
+        auto* bytes = reinterpret_cast<unsigned char*>(copy.data());
+        bytes[at] ^= 0x10;
+        try {
+            readReplay<0>(copy.data(), file.size());
+            accepted++;
+        } catch (const std::invalid_argument&) {
+        }
+        bytes[at] ^= 0x10;
+    }
+    wrong += accepted;
+    std::printf("%zu/%zu copies with a damaged header accepted\n", accepted, rosterEnd);
+
+    std::remove(path);
+    std::printf("%llu wrong\n", (unsigned long long)wrong);
+    return wrong == 0 ? 0 : 1;
+}
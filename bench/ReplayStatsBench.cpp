@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/ReplayCheck.hpp"
+#include "lcycle/ReplayFile.hpp"
+#include "lcycle/ReplayStats.hpp"
+#include "lcycle/World.hpp"
+#include "util/WorkerPool.hpp"
+
+// Records a corpus of minute long matches between wandering bots, reads it
+// back, and tallies ReplayStats over it twice: on one instance, and on one per
+// thread of a pool merged at the end, the way lcycles-analyze does. Checks the
+// two agree, that every death and match is counted once, and that the
+// survival curves start at 1 and only fall, that matches stopped with players
+// left are kept out when asked, and compares the time taken with just playing
+// the matches through.
+
+int main() {
+    using namespace lcycle;
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+
+    constexpr int kReplays = 100;
+    constexpr double kArena = 200.0;
+    constexpr size_t kMaxFrames = 2 * 60 * 60;
+    const fs::path dir = "ReplayStatsBench.d";
+
+    fs::create_directories(dir);
+    std::vector<Replay> replays;
+    for (int i = 0; i < kReplays; i++) {
+        const std::string path = (dir / ("match" + std::to_string(i) + ".lcr")).string();
+        bench::recordMatch(path, i % 2 == 0 ? 2 : 4, kArena, i, kMaxFrames);
+        replays.push_back(readReplay<0>(path));
+    }
+    auto secsSince = [](clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    // players left at the end of each, and the time it takes to just play them
+    uint64_t deaths = 0, frames = 0, finished = 0, finishedDeaths = 0;
+    auto start = clock::now();
+    for (const auto& r : replays) {
+        const ReplayCheck check = checkReplay(r, {});
+        deaths += r.initial().roster().size() - check.alive;
+        frames += check.frames;
+        if (check.alive <= 1) {
+            finished++;
+            finishedDeaths += r.initial().roster().size() - check.alive;
+        }
+    }
+    const double playSecs = secsSince(start);
+
+    start = clock::now();
+    ReplayStats serial;
+    for (const auto& r : replays) serial.add(r);
+    const double serialSecs = secsSince(start);
+
+    util::WorkerPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+    start = clock::now();
+    std::vector<ReplayStats> perThread(pool.threads());
+    pool.forEach(replays.size(), [&](size_t i, int worker) { perThread[worker].add(replays[i]); });
+    ReplayStats merged = perThread[0];
+    for (size_t t = 1; t < perThread.size(); t++) merged.merge(perThread[t]);
+    const double parallelSecs = secsSince(start);
+
+    uint64_t wrong = 0;
+    wrong += serial.deaths() != merged.deaths() || serial.lengths() != merged.lengths() ||
+             serial.entrants() != merged.entrants() || serial.deathBins() != merged.deathBins();
+    double trail = 0.0;
+    for (size_t i = 0; i < serial.trails().size(); i++) {
+        trail += serial.trails()[i];
+        wrong += std::abs(serial.trails()[i] - merged.trails()[i]) > 1e-9 * std::max(1.0, serial.trails()[i]);
+    }
+    uint64_t heatmapDeaths = 0, binnedDeaths = 0, lengths = 0;
+    for (uint64_t d : merged.deaths()) heatmapDeaths += d;
+    for (const auto& bins : merged.deathBins()) {
+        for (uint64_t d : bins) binnedDeaths += d;
+    }
+    for (uint64_t l : merged.lengths()) lengths += l;
+    wrong += heatmapDeaths != deaths || binnedDeaths != deaths || lengths != kReplays ||
+             merged.matches() != kReplays || merged.frames() != frames;
+    for (size_t place = 0; place < merged.entrants().size(); place++) {
+        wrong += merged.survival(place, 0) != 1.0;
+        for (uint64_t f = merged.binFrames(); f <= kMaxFrames; f += merged.binFrames()) {
+            wrong += merged.survival(place, f) > merged.survival(place, f - merged.binFrames());
+        }
+    }
+
+    // with the same matches stopped a second in, with everyone alive, mixed
+    // in, which are the ones to leave out
+    ReplayStats onlyFinished;
+    uint64_t added = 0, finishedHeatmapDeaths = 0;
+    for (int i = 0; i < kReplays; i++) {
+        const std::string path = (dir / ("short" + std::to_string(i) + ".lcr")).string();
+        bench::recordMatch(path, i % 2 == 0 ? 2 : 4, kArena, i, 60);
+        added += onlyFinished.addIfFinished(readReplay<0>(path));
+        added += onlyFinished.addIfFinished(replays[i]);
+    }
+    for (uint64_t d : onlyFinished.deaths()) finishedHeatmapDeaths += d;
+    wrong += added != finished || onlyFinished.matches() != finished || finishedHeatmapDeaths != finishedDeaths;
+
+    merged.writeCsv(dir.string());
+    std::ifstream csv(dir / "deaths.csv");
+    wrong += std::count(std::istreambuf_iterator<char>(csv), std::istreambuf_iterator<char>(), '\n') !=
+             merged.cells();
+
+    std::printf("%d replays, %llu finished, %llu ticks, %llu deaths, %.0f units of trail\n", kReplays,
+                (unsigned long long)finished, (unsigned long long)frames, (unsigned long long)deaths, trail);
+    std::printf("playing only:           %10.0f ticks/sec\n", frames / playSecs);
+    std::printf("stats on one instance:  %10.0f ticks/sec\n", frames / serialSecs);
+    std::printf("stats on %2d, merged:    %10.0f ticks/sec\n", pool.threads(), frames / parallelSecs);
+    std::printf("survival after 30 s / 60 s:");
+    for (size_t place = 0; place < merged.entrants().size(); place++) {
+        std::printf(" place %zu %.2f / %.2f", place, merged.survival(place, 30 * 60), merged.survival(place, 60 * 60));
+    }
+    std::printf("\n");
+
+    fs::remove_all(dir);
+    std::printf("%llu wrong\n", (unsigned long long)wrong);
+    return wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/JournalRollbackWorld.hpp"
+#include "lcycle/RollbackWorld.hpp"
+#include "lcycle/World.hpp"
+
+// Drives both rollback worlds through scripted matches, now and then
+// correcting a player's input some frames back, and checks they end where a
+// world replaying the corrected inputs from the start does. Then times a
+// correction at depths from 1 to 60 frames, which plays that many frames
+// again, in a match where all the players are still alive.
+int main() {
+    using namespace lcycle;
+
+    constexpr int kGames = 50;
+    constexpr int kMaxTicks = 20000;
+    constexpr int kPlayers = 4;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    uint64_t ticks = 0, corrections = 0, mismatches = 0;
+    for (int game = 0; game < kGames; game++) {
+        World w(50.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+        RollbackWorld copying(w, kTimePerFrame);
+        JournalRollbackWorld journal(w, kTimePerFrame);
+        bench::ScriptedInputs inputs(kPlayers, game);
+        // every frame's inputs, corrected along with the rollback worlds
+        std::vector<PlayerInputs> log;
+        uint32_t rng = game;
+
+        for (int tick = 0; tick < kMaxTicks && journal.latest()->players().size() > 1; tick++) {
+            log.push_back(inputs.next());
+            copying.advance(log.back());
+            journal.advance(log.back());
+            ticks++;
+
+            rng = rng * 1664525u + 1013904223u;
+            const int64_t frame = journal.frame() - 1 - (int64_t)((rng >> 8) % 60);
+            if ((rng >> 24) < 8 && frame >= 0) {
+                const int id = (rng >> 4) % kPlayers;
+                const CycleInput input = {(float)((int)(rng >> 16) % 3 - 1)};
+                copying.correct(frame, id, input);
+                journal.correct(frame, id, input);
+                for (size_t f = frame; f < log.size(); f++) setInput(log[f], id, input);
+                corrections++;
+            }
+        }
+        World replayed = w;
+        for (const auto& in : log) replayed.runFor(kTimePerFrame, in);
+        if (copying.stateHash() != replayed.stateHash() || journal.stateHash() != replayed.stateHash() ||
+            copying.frame() != (int64_t)log.size() || journal.frame() != (int64_t)log.size()) {
+            mismatches++;
+        }
+    }
+    std::printf("%llu ticks, %llu corrections, %llu mismatching games\n", (unsigned long long)ticks,
+                (unsigned long long)corrections, (unsigned long long)mismatches);
+
+    // part way into a match of wandering bots who all live through it,
+    // correcting a frame further and further back
+    std::printf("%8s %20s %20s %14s %14s\n", "depth", "copying", "journal", "copying/frame", "journal/frame");
+    World w(200.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    RollbackWorld copying(w, kTimePerFrame);
+    JournalRollbackWorld journal(w, kTimePerFrame);
+    PlayerInputs in;
+    for (int i = 0; i < kPlayers; i++) in.push_back({i, {0.0f}});
+    uint32_t rng = 1;
+    for (int tick = 0; tick < 600; tick++) {
+        bench::wander(*journal.latest(), rng, in);
+        copying.advance(in);
+        journal.advance(in);
+    }
+    // timings of a world someone's died in don't count
+    auto everyone = [&]() {
+        return copying.latest()->players().size() == kPlayers && journal.latest()->players().size() == kPlayers;
+    };
+    uint64_t stale = !everyone();
+    for (int depth : {1, 2, 4, 8, 15, 30, 45, 60}) {
+        // flips player 0 between left and right, so every correction changes something
+        float dir = 1.0f;
+        double copyNs = bench::nsPerRun(200, [&]() {
+            dir = -dir;
+            copying.correct(copying.frame() - depth, 0, {dir});
+        });
+        double journalNs = bench::nsPerRun(200, [&]() {
+            dir = -dir;
+            journal.correct(journal.frame() - depth, 0, {dir});
+        });
+        stale += !everyone();
+        std::printf("%8d %17.1f ns %17.1f ns %11.1f ns %11.1f ns\n", depth, copyNs, journalNs, copyNs / depth,
+                    journalNs / depth);
+    }
+    std::printf("%llu timings with players dead\n", (unsigned long long)stale);
+    return mismatches == 0 && stale == 0 ? 0 : 1;
+}
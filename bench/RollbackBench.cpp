@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/JournalRollbackWorld.hpp"
+#include "lcycle/RollbackWorld.hpp"
+#include "lcycle/World.hpp"
+
+// Drives the copying RollbackWorld and the JournalRollbackWorld through the
+// same scripted matches, rolling back now and then, and checks they always
+// agree, down to the state hash of the oldest frame they can roll back to.
+// Then times an advance and rollback of one frame on both as the trails
+// grow, and reports how much memory each keeps for a given depth, failing if
+// that's more than a tenth off what they really hold on the heap.
+
+namespace {
+
+size_t live = 0;
+
+void* allocate(size_t size, size_t align) {
+    // over-allocate and stash the pointer malloc gave us and the size just below the block
+    void* raw = std::malloc(size + align + 2 * sizeof(void*));
+    if (!raw) throw std::bad_alloc();
+    uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + 2 * sizeof(void*) + align - 1) & ~(uintptr_t)(align - 1);
+    reinterpret_cast<void**>(p)[-1] = raw;
+    reinterpret_cast<size_t*>(p)[-2] = size;
+    live += size;
+    return reinterpret_cast<void*>(p);
+}
+
+void release(void* p) {
+    if (!p) return;
+    live -= reinterpret_cast<size_t*>(p)[-2];
+    std::free(reinterpret_cast<void**>(p)[-1]);
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t align) { return allocate(size, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align) { return allocate(size, (size_t)align); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { release(p); }
+
+namespace {
+
+const lcycle::PlayerInputs kStraight = {{0, {0.0f}}, {1, {0.0f}}, {2, {0.0f}}, {3, {0.0f}}};
+
+/*!
+ * Plays frames frames of everyone driving straight on a rollback world over
+ * w and returns what its bytes() says next to what its history really holds
+ * on the heap, which is how much more it allocated than a plain copy of w
+ * playing the same frames. Sets dead if anyone died on the way.
+ */
+template <typename RW, typename W>
+std::pair<size_t, size_t> historyBytes(const W& w, int depth, int frames, bool& dead, size_t budget = SIZE_MAX) {
+    const size_t before = live;
+    size_t plain = 0;
+    {
+        W world(w);
+        for (int i = 0; i < frames; i++) world.runFor(1.0 / 60.0, kStraight);
+        plain = live - before;
+        dead |= world.players().size() != kStraight.size();
+    }
+    RW rw(w, 1.0 / 60.0, depth, budget);
+    for (int i = 0; i < frames; i++) rw.advance(kStraight);
+    return {rw.bytes(), live - before - plain};
+}
+
+// more than a tenth off
+bool off(const std::pair<size_t, size_t>& b) { return b.first * 10 < b.second * 9 || b.first * 10 > b.second * 11; }
+
+bool sameWorld(const lcycle::World& a, const lcycle::World& b) {
+    if (a.players().size() != b.players().size()) return false;
+    for (size_t i = 0; i < a.players().size(); i++) {
+        const auto la = a.players()[i].cycle.toLine();
+        const auto lb = b.players()[i].cycle.toLine();
+        if (a.players()[i].id != b.players()[i].id || la.start() != lb.start() || la.end() != lb.end()) return false;
+    }
+    for (size_t t = 0; t < a.trails().size(); t++) {
+        const auto& ta = a.trails()[t];
+        const auto& tb = b.trails()[t];
+        if (ta.size() != tb.size()) return false;
+        for (size_t k = 0; k < ta.size(); k++) {
+            if (ta[k].start() != tb[k].start() || ta[k].end() != tb[k].end()) return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    using namespace lcycle;
+
+    constexpr int kGames = 100;
+    constexpr int kMaxTicks = 20000;
+    constexpr int kPlayers = 4;
+
+    uint64_t ticks = 0, rollbacks = 0, mismatches = 0;
+    for (int game = 0; game < kGames; game++) {
+        World w(50.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+        RollbackWorld copying(w);
+        JournalRollbackWorld journal(w);
+        bench::ScriptedInputs inputs(kPlayers, game);
+        uint32_t rng = game;
+        // frames both can undo
+        int history = 0;
+
+        for (int tick = 0; tick < kMaxTicks && copying.latest()->players().size() > 1; tick++) {
+            const auto& in = inputs.next();
+            copying.advance(in);
+            journal.advance(in);
+            history = std::min(history + 1, DEFAULT_ROLLBACK_DEPTH);
+            ticks++;
+
+            rng = rng * 1664525u + 1013904223u;
+            int frames = 1 + (rng >> 8) % 40;
+            if ((rng >> 24) < 4 && frames <= history) {
+                copying.rollback(frames);
+                journal.rollback(frames);
+                history -= frames;
+                rollbacks++;
+            }
+            if (!sameWorld(*copying.latest(), *journal.latest()) || copying.stateHash() != journal.stateHash() ||
+                copying.stateHash(history) != journal.stateHash(history)) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    std::printf("%llu ticks, %llu rollbacks, %llu mismatching games\n", (unsigned long long)ticks,
+                (unsigned long long)rollbacks, (unsigned long long)mismatches);
+
+    // a long match on an arena big enough for cycles to go straight all
+    // through it, so trails keep growing and nobody hits a wall
+    std::printf("%10s %20s %20s\n", "segments", "copying", "journal");
+    World big(400.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    RollbackWorld copying(big);
+    JournalRollbackWorld journal(big);
+    const PlayerInputs& straight = kStraight;
+    uint64_t stale = 0;
+    for (int tick = 1; tick <= 1024; tick++) {
+        copying.advance(straight);
+        journal.advance(straight);
+        if ((tick & (tick - 1)) != 0 || tick < 64) continue;
+
+        // timings of a world someone's died in don't count
+        stale += journal.latest()->players().size() != kPlayers;
+        size_t segments = 0;
+        for (const auto& trail : journal.latest()->trails()) segments += trail.size();
+        // one frame forward and back again
+        double copyNs = bench::nsPerRun(100, [&]() {
+            copying.advance(straight);
+            copying.rollback(1);
+        });
+        double journalNs = bench::nsPerRun(100, [&]() {
+            journal.advance(straight);
+            journal.rollback(1);
+        });
+        std::printf("%10zu %17.1f ns %17.1f ns\n", segments, copyNs, journalNs);
+    }
+
+    // a LAN session, the default, and a few seconds for a slow link, each
+    // played a second past full, what bytes() says over what's really held
+    std::printf("%10s %21s %21s %21s %21s\n", "depth", "copying", "journal", "copying<4>", "journal<4>");
+    World w(200.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    BasicWorld<4> w4(200.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+    uint64_t wrong = 0;
+    bool dead = false;
+    for (int depth : {8, DEFAULT_ROLLBACK_DEPTH, 240}) {
+        const int frames = depth + 60;
+        const std::pair<size_t, size_t> bytes[] = {
+            historyBytes<RollbackWorld>(w, depth, frames, dead),
+            historyBytes<JournalRollbackWorld>(w, depth, frames, dead),
+            historyBytes<BasicRollbackWorld<4>>(w4, depth, frames, dead),
+            historyBytes<BasicJournalRollbackWorld<4>>(w4, depth, frames, dead),
+        };
+        std::printf("%10d", depth);
+        for (const auto& b : bytes) {
+            std::printf(" %9zu/%9zu B", b.first, b.second);
+            wrong += off(b);
+        }
+        std::printf("\n");
+    }
+    const size_t budget = 64 * 1024;
+    const auto capped = historyBytes<RollbackWorld>(w, 240, 300, dead, budget);
+    RollbackWorld keeps(w, 1.0 / 60.0, 240, budget);
+    for (int i = 0; i < 300; i++) keeps.advance(straight);
+    std::printf("240 frames within 64 KiB: copying keeps %d, holding %zu/%zu B\n", keeps.history(), capped.first,
+                capped.second);
+    wrong += off(capped) || capped.first > budget;
+    stale += dead;
+    std::printf("%llu memory counts wrong\n", (unsigned long long)wrong);
+    std::printf("%llu timings with players dead\n", (unsigned long long)stale);
+    return mismatches == 0 && stale == 0 && wrong == 0 ? 0 : 1;
+}
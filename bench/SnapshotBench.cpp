@@ -0,0 +1,177 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+#include "lcycle/WorldSnapshot.hpp"
+#include "util/MappedFile.hpp"
+
+// Snapshots scripted matches part way through, loads the snapshot into a
+// fresh world and plays both on. Reports what taking, loading, copying and
+// hashing a snapshot cost next to copying a World, and whether the loaded
+// worlds snapshot to the same bytes and finish their matches the same way.
+// Each snapshot also goes through a file, which is mapped back in and loaded
+// straight from a view of the mapping; ns/view is what checking the mapped
+// bytes costs. Last, crafted snapshots that would crash a world have to be
+// rejected.
+int main() {
+    using namespace lcycle;
+
+    constexpr int kGames = 20;
+    constexpr int kSnapshotTick = 600;
+    constexpr int kMaxTicks = 20000;
+    constexpr int kCompactEvery = 60;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    const char* path = "SnapshotBench.lcws";
+
+    std::printf("%8s %10s %12s %12s %12s %12s %12s %12s %8s\n", "players", "bytes", "ns/snapshot", "ns/load",
+                "ns/memcpy", "ns/view", "ns/hash", "ns/copy", "same");
+    for (int nPlayers : {2, 4, 8}) {
+        double bytes = 0.0, snapshotNs = 0.0, loadNs = 0.0, memcpyNs = 0.0, viewNs = 0.0, hashNs = 0.0, copyNs = 0.0;
+        int same = 0;
+
+        for (int game = 0; game < kGames; game++) {
+            const auto players = bench::circleOfPlayers(nPlayers, 8.0f);
+            World w(50.0, 0.14, players);
+            bench::ScriptedInputs inputs(nPlayers, game);
+            int tick = 0;
+            for (; tick < kSnapshotTick; tick++) {
+                w.runFor(kTimePerFrame, inputs.next());
+                if (tick % kCompactEvery == kCompactEvery - 1) w.compact();
+            }
+
+            WorldSnapshot snap;
+            w.snapshot(snap);
+            World loaded(50.0, 0.14, players);
+            loaded.load(snap);
+            WorldSnapshot again;
+            loaded.snapshot(again);
+            bool ok = snap.bytes() == again.bytes() && std::memcmp(snap.data(), again.data(), snap.bytes()) == 0;
+
+            snap.save(path);
+            {
+                util::MappedFile file(path);
+                World mapped(50.0, 0.14, players);
+                mapped.load(WorldSnapshotView(file.data(), file.size()));
+                mapped.snapshot(again);
+                ok = ok && again.hash() == snap.hash();
+                viewNs += bench::nsPerRun(200, [&]() {
+                    WorldSnapshotView view(file.data(), file.size());
+                    bench::sink += view.header().segments;
+                });
+            }
+
+            bytes += snap.bytes();
+            snapshotNs += bench::nsPerRun(200, [&]() {
+                w.snapshot(again);
+                bench::sink += again.bytes();
+            });
+            loadNs += bench::nsPerRun(200, [&]() {
+                loaded.load(snap);
+                bench::sink += loaded.players().size();
+            });
+            memcpyNs += bench::nsPerRun(200, [&]() {
+                again = snap;
+                bench::sink += again.bytes();
+            });
+            hashNs += bench::nsPerRun(200, [&]() { bench::sink += snap.hash(); });
+            copyNs += bench::nsPerRun(200, [&]() {
+                World copy = w;
+                bench::sink += copy.players().size();
+            });
+
+            // both worlds have to play the rest of the match identically
+            for (; tick < kMaxTicks && w.players().size() > 1; tick++) {
+                const auto& in = inputs.next();
+                w.runFor(kTimePerFrame, in);
+                loaded.runFor(kTimePerFrame, in);
+                if (tick % kCompactEvery == kCompactEvery - 1) {
+                    w.compact();
+                    loaded.compact();
+                }
+            }
+            w.snapshot(snap);
+            loaded.snapshot(again);
+            ok = ok && snap.hash() == again.hash();
+            same += ok;
+        }
+
+        std::printf("%8d %10.0f %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f %7d%%\n", nPlayers, bytes / kGames,
+                    snapshotNs / kGames, loadNs / kGames, memcpyNs / kGames, viewNs / kGames, hashNs / kGames,
+                    copyNs / kGames, 100 * same / kGames);
+    }
+    std::remove(path);
+
+    // snapshots that are consistent on their face but would crash a world
+    // they're loaded into, each has to be turned away
+    const auto players = bench::circleOfPlayers(4, 8.0f);
+    WorldSnapshot fresh;
+    World(50.0, 0.14, players).snapshot(fresh);
+    auto accepted = [](const WorldSnapshot& s) {
+        try {
+            WorldSnapshot copy;
+            copy.assign(s.data(), s.bytes());
+            return true;
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+    };
+    // fresh's state under header h, with any players beyond fresh's on trail 0
+    WorldSnapshot bad;
+    auto rewrite = [&](const WorldSnapshot::Header& h) {
+        const WorldSnapshot::Header& f = fresh.header();
+        bad.reset(h);
+        for (uint32_t i = 0; i < h.players; i++) {
+            bad.players()[i] = fresh.players()[i < f.players ? i : 0];
+            bad.players()[i].sweepOrder = i;
+        }
+        std::memcpy(bad.trails(), fresh.trails(), f.trails * sizeof(WorldSnapshot::TrailState));
+        std::memcpy(bad.gridHeads(), fresh.gridHeads(), f.gridCells * sizeof(uint32_t));
+    };
+    int crafted = 0, passed = 0;
+    auto craft = [&]() {
+        crafted++;
+        passed += accepted(bad);
+    };
+    WorldSnapshot::Header h = fresh.header();
+    rewrite(h);
+    const bool freshOk = accepted(bad);
+    // drawing with no segment to extend
+    h.drawing = 1;
+    rewrite(h);
+    craft();
+    h = fresh.header();
+    rewrite(h);
+    bad.players()[1].trail = bad.players()[0].trail;
+    craft();
+    rewrite(h);
+    bad.players()[1].id = bad.players()[0].id;
+    craft();
+    h.players = h.trails + 1;
+    rewrite(h);
+    craft();
+    // arenas a world would take forever to play or allocate a huge grid for
+    for (double dashTime : {1e-9, -0.14, std::nan("")}) {
+        h = fresh.header();
+        h.dashTime = dashTime;
+        rewrite(h);
+        craft();
+    }
+    for (double size : {1e5, 0.0, -50.0, std::nan("")}) {
+        h = fresh.header();
+        h.size = size;
+        rewrite(h);
+        craft();
+    }
+    h = fresh.header();
+    h.curTime = std::numeric_limits<double>::infinity();
+    rewrite(h);
+    craft();
+    std::printf("%d/%d crafted snapshots accepted, fresh one %s\n", passed, crafted, freshOk ? "accepted" : "rejected");
+    return passed == 0 && freshOk ? 0 : 1;
+}
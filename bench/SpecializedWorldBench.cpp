@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+
+// Plays the same scripted 2 and 4 player matches on the generic World and on
+// the BasicWorld specialized for that player count, comparing tick and copy
+// times and checking that every match ends the same way.
+
+namespace {
+
+struct Result {
+    uint64_t ticks = 0;
+    double tickNs = 0.0;
+    double copyNs = 0.0;
+    std::vector<int> survivors;
+};
+
+template <size_t N>
+Result play(int nPlayers, uint32_t seed) {
+    using namespace lcycle;
+
+    constexpr int kMaxTicks = 20000;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    BasicWorld<N> w(50.0, 0.14, bench::circleOfPlayers(nPlayers, 8.0f));
+    w.reserve(4096);
+    bench::ScriptedInputs inputs(nPlayers, seed);
+    Result r;
+
+    auto start = std::chrono::steady_clock::now();
+    for (; r.ticks < kMaxTicks && w.players().size() > 1; r.ticks++) w.runFor(kTimePerFrame, inputs.next());
+    r.tickNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // rollback copies the world every tick
+    r.copyNs = bench::nsPerRun(1000, [&]() {
+        BasicWorld<N> copy = w;
+        bench::sink += copy.players().size();
+    });
+
+    for (const auto& p : w.players()) r.survivors.push_back(p.id);
+    return r;
+}
+
+template <size_t N>
+void compare() {
+    constexpr int kGames = 100;
+
+    uint64_t ticks = 0, same = 0;
+    double genericNs = 0.0, fixedNs = 0.0, genericCopy = 0.0, fixedCopy = 0.0;
+    for (int game = 0; game < kGames; game++) {
+        Result generic = play<0>(N, game);
+        Result fixed = play<N>(N, game);
+        ticks += generic.ticks;
+        genericNs += generic.tickNs;
+        fixedNs += fixed.tickNs;
+        genericCopy += generic.copyNs;
+        fixedCopy += fixed.copyNs;
+        same += generic.ticks == fixed.ticks && generic.survivors == fixed.survivors;
+    }
+
+    std::printf("%zu players, %llu ticks, %llu/%d matches identical\n", N, (unsigned long long)ticks,
+                (unsigned long long)same, kGames);
+    bench::report("World::runFor", genericNs / ticks);
+    bench::report("BasicWorld<N>::runFor", fixedNs / ticks);
+    bench::report("World copy", genericCopy / kGames);
+    bench::report("BasicWorld<N> copy", fixedCopy / kGames);
+}
+
+}  // namespace
+
+int main() {
+    compare<2>();
+    compare<4>();
+    return 0;
+}
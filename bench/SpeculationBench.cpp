@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/RollbackWorld.hpp"
+#include "lcycle/World.hpp"
+#include "util/WorkerPool.hpp"
+
+// Plays scripted matches as player 0, with everyone else's inputs arriving a
+// frame late: each frame is played with their last known inputs, and rolled
+// back and played again when the real ones turn out different. Once plainly
+// and once speculating on every way a remote player could have turned, which
+// should take most of the resimulating off the correction. Reports the cost
+// of a frame and of a correction, not counting the time it takes the remote
+// inputs to arrive, and checks both end where a world that had every input in
+// time does.
+int main() {
+    using namespace lcycle;
+    using clock = std::chrono::steady_clock;
+
+    constexpr int kGames = 20;
+    constexpr int kMaxTicks = 20000;
+    constexpr int kPlayers = 4;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+    // far less than a real round trip, but plenty for the workers to finish
+    constexpr auto kLatency = std::chrono::microseconds(200);
+
+    util::WorkerPool pool;
+    std::vector<int> remote;
+    for (int id = 1; id < kPlayers; id++) remote.push_back(id);
+
+    std::printf("%d worker threads\n", pool.threads());
+    std::printf("%12s %10s %12s %12s %16s %8s\n", "mode", "frames", "corrections", "ns/frame", "ns/correction",
+                "same");
+    for (bool speculate : {false, true}) {
+        uint64_t frames = 0, corrections = 0;
+        double frameNs = 0.0, correctionNs = 0.0;
+        int same = 0;
+
+        for (int game = 0; game < kGames; game++) {
+            World w(50.0, 0.14, bench::circleOfPlayers(kPlayers, 8.0f));
+            World reference = w;
+            RollbackWorld rb(w);
+            bench::ScriptedInputs inputs(kPlayers, game);
+            PlayerInputs known = inputs.next();
+
+            for (int tick = 0; tick < kMaxTicks && reference.players().size() > 1; tick++) {
+                const PlayerInputs actual = inputs.next();
+                PlayerInputs predicted = actual;
+                for (size_t i = 1; i < predicted.size(); i++) predicted[i].second = known[i].second;
+                reference.runFor(kTimePerFrame, actual);
+
+                auto start = clock::now();
+                if (speculate) rb.speculate(alternativeInputs(predicted, remote), pool);
+                rb.advance(predicted);
+                auto played = clock::now();
+                std::this_thread::sleep_for(kLatency);
+                // the remote inputs for this frame arrive
+                auto arrived = clock::now();
+                bool wrong = false;
+                for (size_t i = 1; i < actual.size(); i++) {
+                    wrong = wrong || actual[i].second.turnDir != predicted[i].second.turnDir;
+                }
+                if (wrong) {
+                    rb.rollback(1);
+                    rb.advance(actual);
+                    corrections++;
+                }
+                auto corrected = clock::now();
+                frameNs += std::chrono::duration<double, std::nano>(played - start + corrected - arrived).count();
+                correctionNs += std::chrono::duration<double, std::nano>(corrected - arrived).count() * wrong;
+                known = actual;
+                frames++;
+            }
+            same += rb.latest()->stateHash() == reference.stateHash();
+        }
+
+        std::printf("%12s %10llu %12llu %12.1f %16.1f %7d%%\n", speculate ? "speculative" : "plain",
+                    (unsigned long long)frames, (unsigned long long)corrections, frameNs / frames,
+                    correctionNs / corrections, 100 * same / kGames);
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <vectorial/config.h>
+
+#include "Bench.hpp"
+#include "lcycle/Cycle.hpp"
+
+// Compares steering cycles one at a time with the batched simd4f path, on the
+// same cycles and turns, and checks that both land in exactly the same place.
+int main() {
+    using namespace lcycle;
+
+    constexpr size_t kCycles = 1024;
+    constexpr int kRuns = 2000;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-25.0f, 25.0f);
+    std::uniform_real_distribution<double> angle(0.0, 2 * M_PI);
+    std::uniform_int_distribution<int> dir(-1, 1);
+
+    std::vector<Cycle> one, all;
+    std::vector<double> turns;
+    for (size_t i = 0; i < kCycles; i++) {
+        one.emplace_back(mathfu::vec2(pos(rng), pos(rng)), angle(rng));
+        turns.push_back(-1 * TURN_SPEED * kTimePerFrame * dir(rng));
+    }
+    all = one;
+    std::vector<Cycle*> ptrs;
+    for (auto& c : all) ptrs.push_back(&c);
+
+    auto steerOne = [&]() {
+        for (size_t i = 0; i < kCycles; i++) one[i].steer(kTimePerFrame, turns[i]);
+        bench::sink += (uint64_t)one[0].toLine().end().x();
+    };
+    auto steerAll = [&]() {
+        Cycle::steerAll(kTimePerFrame, ptrs.data(), turns.data(), kCycles);
+        bench::sink += (uint64_t)all[0].toLine().end().x();
+    };
+
+    double scalar = bench::nsPerRun(kRuns, steerOne);
+    double simd = bench::nsPerRun(kRuns, steerAll);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < kCycles; i++) {
+        Line a = one[i].toLine();
+        Line b = all[i].toLine();
+        if (a.start() != b.start() || a.end() != b.end()) mismatches++;
+    }
+
+    std::printf("%zu cycles (%s)\n", kCycles, VECTORIAL_SIMD_TYPE);
+    bench::report("Cycle::steer", scalar, kCycles);
+    bench::report("Cycle::steerAll", simd, kCycles);
+    std::printf("speedup %.2fx, %zu mismatching cycles\n", scalar / simd, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "Bench.hpp"
+#include "lcycle/World.hpp"
+
+// Counts every heap allocation made while World::runFor is running and fails
+// if any tick allocates. Each world is reserve()d up front, after which ticks
+// must run entirely out of preallocated trail, grid and scratch storage.
+
+namespace {
+
+bool counting = false;
+uint64_t allocations = 0;
+
+void* allocate(size_t size, size_t align) {
+    if (counting) allocations++;
+    // over-allocate and stash the pointer malloc gave us just below the block
+    void* raw = std::malloc(size + align + sizeof(void*));
+    if (!raw) throw std::bad_alloc();
+    uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(uintptr_t)(align - 1);
+    reinterpret_cast<void**>(p)[-1] = raw;
+    return reinterpret_cast<void*>(p);
+}
+
+void release(void* p) {
+    if (p) std::free(reinterpret_cast<void**>(p)[-1]);
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t align) { return allocate(size, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align) { return allocate(size, (size_t)align); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { release(p); }
+
+int main() {
+    using namespace lcycle;
+
+    constexpr int kGames = 200;
+    constexpr int kMaxTicks = 20000;
+    constexpr double kTimePerFrame = 1.0 / 60.0;
+
+    uint64_t ticks = 0;
+    uint64_t badTicks = 0;
+    double secs = 0.0;
+
+    for (int game = 0; game < kGames; game++) {
+        const int nPlayers = 2 + game % 7;
+        World w(50.0, 0.14, bench::circleOfPlayers(nPlayers));
+        w.reserve(4096);
+
+        bench::ScriptedInputs inputs(nPlayers, game);
+        for (int tick = 0; tick < kMaxTicks && w.players().size() > 1; tick++) {
+            const auto& in = inputs.next();
+
+            allocations = 0;
+            counting = true;
+            auto start = std::chrono::steady_clock::now();
+            w.runFor(kTimePerFrame, in);
+            secs += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            counting = false;
+
+            ticks++;
+            if (allocations > 0) {
+                badTicks++;
+                std::printf("game %d tick %d: %llu allocations\n", game, tick, (unsigned long long)allocations);
+            }
+        }
+    }
+
+    std::printf("%llu ticks, %llu allocating, %.0f ticks/sec\n", (unsigned long long)ticks,
+                (unsigned long long)badTicks, ticks / secs);
+    return badTicks == 0 ? 0 : 1;
+}
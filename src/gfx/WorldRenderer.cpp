@@ -9,7 +9,8 @@ namespace gfx {
 WorldRenderer::WorldRenderer()
     : _trails(GL_ARRAY_BUFFER), _cycles(GL_ARRAY_BUFFER), _bg(GL_ARRAY_BUFFER), _vao(), _buf() {}
 
-void WorldRenderer::render(const lcycle::World& w) {
+template <size_t N>
+void WorldRenderer::render(const lcycle::BasicWorld<N>& w) {
     const float sizeDiv2 = w.size() / 2.0;
     const GLfloat bgVecs[] = {-sizeDiv2, -sizeDiv2, -sizeDiv2, sizeDiv2, sizeDiv2, sizeDiv2, sizeDiv2, -sizeDiv2};
     _bg.data(sizeof(bgVecs), &bgVecs, GL_STATIC_DRAW);
@@ -19,7 +20,10 @@ void WorldRenderer::render(const lcycle::World& w) {
     const auto& trails = w.trails();
 
     size_t nLines = 0;
-    for (const auto& trail : trails) nLines += trail.size();
+    for (const auto& trail : trails) {
+        nLines += trail.size();
+        for (const auto& run : trail.runs()) nLines += run.count;
+    }
 
     const size_t bufSize = 4 * std::max(players.size(), nLines);
     _buf.resize(bufSize);
@@ -40,14 +44,34 @@ void WorldRenderer::render(const lcycle::World& w) {
 
     size_t curOffset = 0;
     for (auto& trail : trails) {
-        for (size_t i = 0; i < trail.size(); i++) {
-            buf[curOffset + 0] = trail[i].start().x();
-            buf[curOffset + 1] = trail[i].start().y();
+        for (size_t b = 0; b < trail.blocks(); b++) {
+            const float* sx = trail.sx(b);
+            const float* sy = trail.sy(b);
+            const float* ex = trail.ex(b);
+            const float* ey = trail.ey(b);
+            const size_t n = std::min(lcycle::Trail::BLOCK, trail.size() - b * lcycle::Trail::BLOCK);
+            for (size_t i = 0; i < n; i++) {
+                buf[curOffset + 0] = sx[i];
+                buf[curOffset + 1] = sy[i];
+
+                buf[curOffset + 2] = ex[i];
+                buf[curOffset + 3] = ey[i];
+
+                curOffset += 4;
+            }
+        }
+        for (const auto& run : trail.runs()) {
+            for (uint32_t k = 0; k < run.count; k++) {
+                const auto dash = run.dash(k);
 
-            buf[curOffset + 2] = trail[i].end().x();
-            buf[curOffset + 3] = trail[i].end().y();
+                buf[curOffset + 0] = dash.start().x();
+                buf[curOffset + 1] = dash.start().y();
 
-            curOffset += 4;
+                buf[curOffset + 2] = dash.end().x();
+                buf[curOffset + 3] = dash.end().y();
+
+                curOffset += 4;
+            }
         }
     }
 
@@ -67,7 +91,7 @@ void WorldRenderer::render(const lcycle::World& w) {
     _vao.vertexAttribPointer(0, 2, GL_FLOAT);
     size_t curStart = 0;
     for (const auto& player : players) {
-        glVertexAttrib4fv(1, &player.color[0]);
+        glVertexAttrib4fv(1, &w.roster().byId(player.id).color[0]);
         glDrawArrays(GL_LINES, curStart, 2);
         curStart += 2;
     }
@@ -76,10 +100,16 @@ void WorldRenderer::render(const lcycle::World& w) {
     _vao.vertexAttribPointer(0, 2, GL_FLOAT);
     curStart = 0;
     for (const auto& trail : trails) {
+        size_t nTrailLines = trail.size();
+        for (const auto& run : trail.runs()) nTrailLines += run.count;
         glVertexAttrib4fv(1, &(trail.color()[0]));
-        glDrawArrays(GL_LINES, curStart, 2 * trail.size());
-        curStart += 2 * trail.size();
+        glDrawArrays(GL_LINES, curStart, 2 * nTrailLines);
+        curStart += 2 * nTrailLines;
     }
 }
 
+template void WorldRenderer::render(const lcycle::BasicWorld<0>& w);
+template void WorldRenderer::render(const lcycle::BasicWorld<2>& w);
+template void WorldRenderer::render(const lcycle::BasicWorld<4>& w);
+
 }  // namespace gfx
@@ -13,7 +13,8 @@ constexpr GLfloat BG_COLOR[4] = {1.0, 1.0, 1.0, 1.0};
 class WorldRenderer {
    public:
     WorldRenderer();
-    void render(const lcycle::World& w);
+    template <size_t N>
+    void render(const lcycle::BasicWorld<N>& w);
 
    private:
     gl::Buffer _trails;
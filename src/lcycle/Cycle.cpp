@@ -1,29 +1,146 @@
 #include "Cycle.hpp"
 
 #include <mathfu/glsl_mappings.h>
+#include <vectorial/simd4f.h>
 #include <functional>
 
 #include <cmath>
 
 namespace lcycle {
 
-Cycle::Cycle(const mathfu::vec2& pos, double orientation) : _pos(pos), _orientation(orientation) {}
+Turn::Turn(double dCC) : degrees(dCC) {
+    // the chord of an arc turning by t points along the mid angle and is
+    // sin(t / 2) / (t / 2) times as long as the arc
+    double half = dCC * M_PI / 360.0;
+    cosHalf = cos(half);
+    sinHalf = sin(half);
+    chord = half == 0.0 ? 1.0 : sin(half) / half;
+}
+
+namespace {
+
+// rotates (x, y) by the angle with the given cosine and sine, then takes one
+// Newton step towards unit length so rounding doesn't build up over a match
+void rotateUnit(float& x, float& y, float c, float s) {
+    float rx = c * x - s * y;
+    float ry = s * x + c * y;
+    float k = 1.5f - 0.5f * (rx * rx + ry * ry);
+    x = rx * k;
+    y = ry * k;
+}
 
-void Cycle::runFor(double secs) {
-    _pos = _pos + (float)(secs * CYCLE_SPEED) * mathfu::vec2(cos(_orientation), sin(_orientation));
+// the same four lanes at a time
+void rotateUnit4(simd4f& x, simd4f& y, simd4f c, simd4f s) {
+    simd4f rx = simd4f_sub(simd4f_mul(c, x), simd4f_mul(s, y));
+    simd4f ry = simd4f_add(simd4f_mul(s, x), simd4f_mul(c, y));
+    simd4f lenSq = simd4f_add(simd4f_mul(rx, rx), simd4f_mul(ry, ry));
+    simd4f k = simd4f_sub(simd4f_splat(1.5f), simd4f_mul(simd4f_splat(0.5f), lenSq));
+    x = simd4f_mul(rx, k);
+    y = simd4f_mul(ry, k);
 }
 
+}  // namespace
+
+Cycle::Cycle(const mathfu::vec2& pos, double orientation)
+    : _pos(pos),
+      _heading(cos(orientation), sin(orientation)),
+      _fixed{toFixed(pos.x()), toFixed(pos.y()), angleFromRadians(orientation)} {}
+
+void Cycle::runFor(double secs) { _pos = _pos + (float)(secs * CYCLE_SPEED) * _heading; }
+
 void Cycle::rotate(double dCC) {
-    double newO = _orientation + dCC * M_PI / 180.0;
-    _orientation = fmod(newO, 2 * M_PI);
+    double rad = dCC * M_PI / 180.0;
+    rotateUnit(_heading.x(), _heading.y(), cos(rad), sin(rad));
+}
+
+void Cycle::steer(double secs, double dCC) { steer(secs, Turn(dCC)); }
+
+void Cycle::steer(double secs, const Turn& turn) {
+    rotateUnit(_heading.x(), _heading.y(), turn.cosHalf, turn.sinHalf);
+    runFor(secs * turn.chord);
+    rotateUnit(_heading.x(), _heading.y(), turn.cosHalf, turn.sinHalf);
+}
+
+void Cycle::steerAll(double secs, Cycle* const* cycles, const double* turns, size_t n) {
+    // most cycles go straight or turn at full lock, so neighbours usually share a turn
+    Turn turn;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float px[4], py[4], hx[4], hy[4], c[4], s[4], dist[4];
+        for (size_t k = 0; k < 4; k++) {
+            const Cycle& cycle = *cycles[i + k];
+            if (turns[i + k] != turn.degrees) turn = Turn(turns[i + k]);
+            px[k] = cycle._pos.x();
+            py[k] = cycle._pos.y();
+            hx[k] = cycle._heading.x();
+            hy[k] = cycle._heading.y();
+            c[k] = turn.cosHalf;
+            s[k] = turn.sinHalf;
+            dist[k] = (float)(secs * turn.chord * CYCLE_SPEED);
+        }
+
+        simd4f x = simd4f_uload4(hx);
+        simd4f y = simd4f_uload4(hy);
+        simd4f cosHalf = simd4f_uload4(c);
+        simd4f sinHalf = simd4f_uload4(s);
+        simd4f d = simd4f_uload4(dist);
+        rotateUnit4(x, y, cosHalf, sinHalf);
+        simd4f newX = simd4f_add(simd4f_uload4(px), simd4f_mul(d, x));
+        simd4f newY = simd4f_add(simd4f_uload4(py), simd4f_mul(d, y));
+        rotateUnit4(x, y, cosHalf, sinHalf);
+
+        simd4f_ustore4(newX, px);
+        simd4f_ustore4(newY, py);
+        simd4f_ustore4(x, hx);
+        simd4f_ustore4(y, hy);
+        for (size_t k = 0; k < 4; k++) {
+            Cycle& cycle = *cycles[i + k];
+            cycle._pos = mathfu::vec2(px[k], py[k]);
+            cycle._heading = mathfu::vec2(hx[k], hy[k]);
+        }
+    }
+    for (; i < n; i++) {
+        if (turns[i] != turn.degrees) turn = Turn(turns[i]);
+        cycles[i]->steer(secs, turn);
+    }
 }
 
 Line Cycle::toLine() const {
     using namespace mathfu;
 
-    vec2 dir = vec2(cos(_orientation), sin(_orientation));
+    vec2 half = (float)(CYCLE_LENGTH / 2.0) * _heading;
+
+    return Line(_pos - half, _pos + half);
+}
+
+const mathfu::vec2& Cycle::pos() const { return _pos; }
+
+const mathfu::vec2& Cycle::heading() const { return _heading; }
 
-    return Line(_pos - (float)(CYCLE_LENGTH / 2.0) * dir, _pos + (float)(CYCLE_LENGTH / 2.0) * dir);
+Cycle Cycle::withHeading(const mathfu::vec2& pos, const mathfu::vec2& heading, const FixedState& fixed) {
+    Cycle c(pos, 0.0);
+    c._heading = heading;
+    c._fixed = fixed;
+    return c;
 }
 
+void Cycle::steerFixed(Fixed distance, int32_t turn) {
+    // along the chord, which points halfway through the turn
+    const Angle mid = _fixed.angle + (Angle)(turn / 2);
+    const int64_t chord = mulShift(distance, fixedChord(turn), 30);
+    _fixed.x += (Fixed)mulShift(chord, fixedCos(mid), 30);
+    _fixed.y += (Fixed)mulShift(chord, fixedSin(mid), 30);
+    _fixed.angle += (Angle)turn;
+    snapToFixed();
+}
+
+void Cycle::snapToFixed() {
+    _pos = mathfu::vec2(fromFixed(_fixed.x), fromFixed(_fixed.y));
+    // exact scaling by 2^-30, the only rounding is converting to float
+    const float scale = 1.0f / (1 << 30);
+    _heading = mathfu::vec2((float)fixedCos(_fixed.angle) * scale, (float)fixedSin(_fixed.angle) * scale);
+}
+
+const Cycle::FixedState& Cycle::fixedState() const { return _fixed; }
+
 }  // namespace lcycle
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "FixedPoint.hpp"
 #include "Line.hpp"
 
 #include <mathfu/glsl_mappings.h>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace lcycle {
@@ -16,16 +19,66 @@ struct CycleInput {
     float turnDir;
 };
 
+/*!
+ * The trig behind one call to Cycle::steer, worked out once so that cycles
+ * turning by the same angle can share it.
+ */
+struct Turn {
+    explicit Turn(double degreesCounterClockwise = 0.0);
+
+    double degrees;
+    // rotation by half the turn
+    float cosHalf, sinHalf;
+    // length of the arc's chord over the length of the arc
+    double chord;
+};
+
 class Cycle {
    public:
+    /*! Position and heading as fixed point steering sees them. */
+    struct FixedState {
+        Fixed x, y;
+        Angle angle;
+    };
+
     Cycle(const mathfu::vec2& pos, double orientation);
     void runFor(double secs);
     void rotate(double degreesCounterClockwise);
+    /*!
+     * Drives for secs while turning by degreesCounterClockwise at a constant
+     * rate, following the exact arc so the result doesn't depend on how the
+     * time is split into steps.
+     */
+    void steer(double secs, double degreesCounterClockwise);
+    void steer(double secs, const Turn& turn);
     Line toLine() const;
+    const mathfu::vec2& pos() const;
+    const mathfu::vec2& heading() const;
+    /*! A cycle at pos pointing along the unit vector heading, with fixed as its fixed point state. */
+    static Cycle withHeading(const mathfu::vec2& pos, const mathfu::vec2& heading, const FixedState& fixed);
+
+    /*!
+     * Same as steer, but works on the fixed point state alone and sets pos
+     * and heading from it afterwards, so the result is bit identical on every
+     * build. Drives distance along the arc turning by turn.
+     */
+    void steerFixed(Fixed distance, int32_t turn);
+    /*! Sets pos and heading from the fixed point state. */
+    void snapToFixed();
+    /*! Only kept up to date by steerFixed, the other ways to move a cycle leave it alone. */
+    const FixedState& fixedState() const;
+
+    /*!
+     * Steers every cycles[k] for secs by turns[k] degrees, four at a time with
+     * simd4f. Gives exactly the same result as calling steer on each.
+     */
+    static void steerAll(double secs, Cycle* const* cycles, const double* turns, size_t n);
 
    private:
     mathfu::vec2 _pos;
-    double _orientation;
+    // unit vector the cycle points along, only ever rotated so the hot path needs no trig
+    mathfu::vec2 _heading;
+    FixedState _fixed;
 };
 
 }  // namespace lcycle
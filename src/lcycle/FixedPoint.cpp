@@ -0,0 +1,91 @@
+#include "FixedPoint.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace lcycle {
+
+namespace {
+
+// entries in the quarter wave table, plus one for the end point
+const int TABLE_BITS = 10;
+const int TABLE_SIZE = 1 << TABLE_BITS;
+// pi / 2 in 2.30 fixed point
+const int64_t HALF_PI_Q30 = 1686629713;
+// 2 pi in 2.30 fixed point
+const uint64_t TWO_PI_Q30 = 6746518852ull;
+
+// sin of the first quadrant at TABLE_SIZE + 1 evenly spaced angles, from its
+// Taylor series in 2.30 fixed point. Terms are kept positive so every shift
+// is of a non-negative number.
+constexpr std::array<int32_t, TABLE_SIZE + 1> quarterWave() {
+    std::array<int32_t, TABLE_SIZE + 1> table = {};
+    for (int i = 0; i <= TABLE_SIZE; i++) {
+        const int64_t x = HALF_PI_Q30 * i / TABLE_SIZE;
+        int64_t term = x;
+        int64_t sum = x;
+        for (int k = 1; term > 0; k++) {
+            term = ((term * x) >> 30) * x >> 30;
+            term /= (2 * k) * (2 * k + 1);
+            sum += k % 2 ? -term : term;
+        }
+        table[i] = (int32_t)(sum > (1 << 30) ? 1 << 30 : sum);
+    }
+    return table;
+}
+
+constexpr std::array<int32_t, TABLE_SIZE + 1> QUARTER_WAVE = quarterWave();
+
+}  // namespace
+
+Fixed toFixed(double v) { return (Fixed)std::llround(v * (1 << FIXED_SHIFT)); }
+
+float fromFixed(Fixed v) { return (float)v / (1 << FIXED_SHIFT); }
+
+Angle angleFromRadians(double radians) {
+    // reduce to a turn first, so the cast below can't overflow
+    double turns = radians / (2 * M_PI);
+    turns -= std::floor(turns);
+    return (Angle)(uint64_t)std::llround(turns * 4294967296.0);
+}
+
+int32_t turnFromDegrees(double degrees) {
+    double turns = degrees / 360.0;
+    if (turns >= 0.5) turns = 0.5 - 1.0 / 4294967296.0;
+    if (turns < -0.5) turns = -0.5;
+    return (int32_t)std::llround(turns * 4294967296.0);
+}
+
+int32_t fixedSin(Angle a) {
+    const uint32_t quadrant = a >> 30;
+    uint32_t r = a & ((1u << 30) - 1);
+    // the second and fourth quadrants run the table backwards
+    if (quadrant & 1) r = (1u << 30) - r;
+    const uint32_t i = r >> (30 - TABLE_BITS);
+    const uint32_t frac = r & ((1u << (30 - TABLE_BITS)) - 1);
+    int32_t v = QUARTER_WAVE[i];
+    if (i < TABLE_SIZE) {
+        v += (int32_t)((int64_t)(QUARTER_WAVE[i + 1] - QUARTER_WAVE[i]) * frac >> (30 - TABLE_BITS));
+    }
+    return quadrant & 2 ? -v : v;
+}
+
+int32_t fixedCos(Angle a) { return fixedSin(a + (1u << 30)); }
+
+int32_t fixedChord(int32_t turn) {
+    const uint32_t half = (turn < 0 ? 0u - (uint32_t)turn : (uint32_t)turn) / 2;
+    // the half angle in radians, 2.30 fixed point
+    const uint64_t h = half * TWO_PI_Q30 >> 32;
+    if (h == 0) return 1 << 30;
+    const uint64_t chord = ((uint64_t)fixedSin(half) << 30) / h;
+    return (int32_t)(chord > (1u << 30) ? 1u << 30 : chord);
+}
+
+int64_t mulShift(int64_t a, int64_t b, int shift) {
+    const int64_t p = a * b;
+    const int64_t half = (int64_t)1 << (shift - 1);
+    return p >= 0 ? (p + half) >> shift : -((-p + half) >> shift);
+}
+
+}  // namespace lcycle
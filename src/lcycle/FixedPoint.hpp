@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lcycle {
+
+/*!
+ * Integer arithmetic for the fixed point kinematics, see
+ * Kinematics::Fixed. Nothing here touches floating point once its inputs are
+ * converted, so results are the same on every compiler, libm and CPU.
+ */
+
+/*! Signed 16.16 fixed point. */
+using Fixed = int32_t;
+const int FIXED_SHIFT = 16;
+
+/*! Angle in 2^-32 turns, wrapping around with the circle. */
+using Angle = uint32_t;
+
+/*! v rounded to the nearest Fixed. */
+Fixed toFixed(double v);
+/*! Exact as long as |v| < 256. */
+float fromFixed(Fixed v);
+
+/*! Rounded to the nearest Angle. */
+Angle angleFromRadians(double radians);
+/*! A signed turn of this many degrees, rounded to the nearest Angle unit. */
+int32_t turnFromDegrees(double degrees);
+
+/*!
+ * sin and cos in signed 2.30 fixed point, interpolated from a quarter wave
+ * table that is itself worked out with integer arithmetic at compile time.
+ * Off by at most a few units in the last place.
+ */
+int32_t fixedSin(Angle a);
+int32_t fixedCos(Angle a);
+
+/*!
+ * How much shorter the chord of an arc turning by turn is than the arc, as
+ * sin(t / 2) / (t / 2) in 2.30 fixed point.
+ */
+int32_t fixedChord(int32_t turn);
+
+/*! a * b / 2^shift, rounded to nearest with halves away from zero. */
+int64_t mulShift(int64_t a, int64_t b, int shift);
+
+}  // namespace lcycle
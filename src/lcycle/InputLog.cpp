@@ -0,0 +1,194 @@
+#include "lcycle/InputLog.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "lcycle/Roster.hpp"
+#include "lcycle/World.hpp"
+
+namespace lcycle {
+
+// codes are turns scaled to [-LEVELS, LEVELS] and offset to be unsigned,
+// which leaves the top code for a player without input that frame
+static constexpr int LEVELS = (1 << (InputLog::TURN_BITS - 1)) - 1;
+static constexpr int CODES_PER_WORD = 64 / InputLog::TURN_BITS;
+static constexpr uint64_t CODE_MASK = (1u << InputLog::TURN_BITS) - 1;
+static constexpr uint64_t NO_INPUT = 2 * LEVELS + 1;
+static_assert(NO_INPUT == CODE_MASK, "every code is a turn or no input");
+
+static uint64_t encode(CycleInput input) {
+    const float turn = std::max(-1.0f, std::min(1.0f, input.turnDir));
+    return (uint64_t)(std::lround(turn * LEVELS) + LEVELS);
+}
+
+static CycleInput decode(uint64_t code) {
+    return {(float)((int)code - LEVELS) / LEVELS};
+}
+
+InputLog::InputLog(std::vector<int> ids)
+    : _ids(std::move(ids)), _slots(), _words(0), _chunks(), _frames(0), _row() {
+    for (size_t i = 0; i < _ids.size(); i++) {
+        const int id = _ids[i];
+        if (id < 0) throw std::invalid_argument("Player ids must be non-negative");
+        if (id > Roster::MAX_ID) throw std::invalid_argument("Player id is too large");
+        if ((size_t)id >= _slots.size()) _slots.resize(id + 1, -1);
+        if (_slots[id] >= 0) throw std::invalid_argument("Player ids must be unique");
+        _slots[id] = i;
+    }
+    _words = (_ids.size() + CODES_PER_WORD - 1) / CODES_PER_WORD;
+    _row.resize(_words);
+}
+
+CycleInput InputLog::quantize(CycleInput input) { return decode(encode(input)); }
+
+void InputLog::push(const PlayerInputs& inputs) {
+    // everyone not listed has no input, and the world leaves them be
+    std::fill(_row.begin(), _row.end(), 0);
+    for (size_t i = 0; i < _ids.size(); i++) _row[i / CODES_PER_WORD] |= NO_INPUT << (i % CODES_PER_WORD * TURN_BITS);
+    for (const auto& input : inputs) {
+        const int id = input.first;
+        if (id < 0 || (size_t)id >= _slots.size() || _slots[id] < 0) {
+            throw std::invalid_argument("Input for a player that isn't logged");
+        }
+        const int slot = _slots[id];
+        const int shift = slot % CODES_PER_WORD * TURN_BITS;
+        uint64_t& word = _row[slot / CODES_PER_WORD];
+        word = (word & ~(CODE_MASK << shift)) | encode(input.second) << shift;
+    }
+    push(_row.data(), 1);
+}
+
+void InputLog::push(const uint64_t* row, size_t frames) {
+    if (!_chunks.empty()) {
+        Chunk& c = _chunks.back();
+        if (std::equal(row, row + _words, c.rows.end() - _words)) {
+            c.ends.back() += (uint32_t)frames;
+            _frames += frames;
+            return;
+        }
+    }
+    if (_chunks.empty() || _chunks.back().ends.size() == RUNS_PER_CHUNK) {
+        _chunks.push_back({_frames, {}, {}});
+        _chunks.back().ends.reserve(RUNS_PER_CHUNK);
+        _chunks.back().rows.reserve(RUNS_PER_CHUNK * _words);
+    }
+    Chunk& c = _chunks.back();
+    c.ends.push_back((uint32_t)(_frames - c.first + frames));
+    c.rows.insert(c.rows.end(), row, row + _words);
+    _frames += frames;
+}
+
+void InputLog::truncate(size_t frames) {
+    if (frames >= _frames) return;
+    if (frames == 0) {
+        _chunks.clear();
+        _frames = 0;
+        return;
+    }
+    size_t chunk, run;
+    find(frames - 1, chunk, run);
+    _chunks.resize(chunk + 1);
+    Chunk& c = _chunks.back();
+    c.ends.resize(run + 1);
+    c.rows.resize((run + 1) * _words);
+    c.ends.back() = (uint32_t)(frames - c.first);
+    _frames = frames;
+}
+
+void InputLog::write(size_t first, size_t frames, std::vector<uint64_t>& out) const {
+    if (first + frames > _frames) throw std::out_of_range("Input log isn't that long");
+    // the runs overlapping the frames, clipped to them
+    struct Span {
+        const uint64_t* row;
+        uint32_t end;
+    };
+    std::vector<Span> spans;
+    if (frames > 0) {
+        size_t chunk, run;
+        find(first, chunk, run);
+        for (size_t end = 0; end < frames; run++) {
+            if (run == _chunks[chunk].ends.size()) {
+                chunk++;
+                run = 0;
+            }
+            const Chunk& c = _chunks[chunk];
+            end = std::min(c.first + c.ends[run] - first, frames);
+            spans.push_back({c.rows.data() + run * _words, (uint32_t)end});
+        }
+    }
+
+    out.push_back((uint64_t)spans.size() << 32 | frames);
+    for (size_t i = 0; i < spans.size(); i += 2) {
+        out.push_back(spans[i].end | (i + 1 < spans.size() ? (uint64_t)spans[i + 1].end << 32 : 0));
+    }
+    for (const auto& span : spans) out.insert(out.end(), span.row, span.row + _words);
+}
+
+void InputLog::append(const uint64_t* data, size_t words) {
+    if (words == 0) throw std::invalid_argument("Input frames are missing their counts");
+    const size_t frames = (uint32_t)data[0];
+    const size_t runs = data[0] >> 32;
+    const size_t endWords = (runs + 1) / 2;
+    if (words != 1 + endWords + runs * _words) throw std::invalid_argument("Input frames have the wrong size");
+    auto end = [data](size_t r) { return (uint32_t)(data[1 + r / 2] >> (r % 2 * 32)); };
+    const uint64_t* rows = data + 1 + endWords;
+
+    // every code is a turn or no input, but only logged players may have one
+    const size_t unused = _words * CODES_PER_WORD - _ids.size();
+    const uint64_t lastMask = unused == 0 ? 0 : ~0ull << (64 - unused * TURN_BITS);
+    uint32_t last = 0;
+    for (size_t r = 0; r < runs; r++) {
+        if (end(r) <= last) throw std::invalid_argument("Input runs are out of order");
+        last = end(r);
+        const uint64_t* row = rows + r * _words;
+        if (_words > 0 && (row[_words - 1] & lastMask)) {
+            throw std::invalid_argument("Input for a player that isn't logged");
+        }
+    }
+    if (last != frames) throw std::invalid_argument("Input runs don't add up");
+
+    for (size_t r = 0, start = 0; r < runs; start = end(r++)) push(rows + r * _words, end(r) - start);
+}
+
+size_t InputLog::frames() const { return _frames; }
+
+void InputLog::find(size_t frame, size_t& chunk, size_t& run) const {
+    auto c = std::upper_bound(_chunks.begin(), _chunks.end(), frame,
+                              [](size_t f, const Chunk& chunk) { return f < chunk.first; });
+    chunk = c - _chunks.begin() - 1;
+    const auto& ends = _chunks[chunk].ends;
+    run = std::upper_bound(ends.begin(), ends.end(), (uint32_t)(frame - _chunks[chunk].first)) - ends.begin();
+}
+
+void InputLog::read(size_t frame, PlayerInputs& out) const {
+    if (frame >= _frames) throw std::out_of_range("Input log isn't that long");
+    size_t chunk, run;
+    find(frame, chunk, run);
+    const uint64_t* row = _chunks[chunk].rows.data() + run * _words;
+    out.clear();
+    for (size_t i = 0; i < _ids.size(); i++) {
+        const uint64_t code = row[i / CODES_PER_WORD] >> (i % CODES_PER_WORD * TURN_BITS) & CODE_MASK;
+        if (code != NO_INPUT) out.push_back({_ids[i], decode(code)});
+    }
+}
+
+const std::vector<int>& InputLog::ids() const { return _ids; }
+
+size_t InputLog::runs() const {
+    size_t runs = 0;
+    for (const auto& c : _chunks) runs += c.ends.size();
+    return runs;
+}
+
+size_t InputLog::bytes() const {
+    size_t bytes = _chunks.capacity() * sizeof(Chunk);
+    for (const auto& c : _chunks) bytes += c.ends.capacity() * sizeof(uint32_t) + c.rows.capacity() * sizeof(uint64_t);
+    return bytes;
+}
+
+}  // namespace lcycle
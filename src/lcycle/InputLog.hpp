@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lcycle/World.hpp"
+
+namespace lcycle {
+
+/*!
+ * Every frame's inputs of a match, packed into a few bits per player. Turns
+ * are quantized to TURN_BITS, which keeps the -1, 0 and 1 of keyboard
+ * steering exact and leaves one code spare to mark a player who had no input
+ * that frame, and the players' codes for a frame are packed into a row of
+ * 64 bit words. A run of frames with the same row is stored once, along with
+ * where it ends, and runs fill fixed size chunks, so recording allocates
+ * about once per RUNS_PER_CHUNK changes of input rather than every frame.
+ */
+class InputLog {
+   public:
+    static constexpr int TURN_BITS = 4;
+    static constexpr size_t RUNS_PER_CHUNK = 1024;
+
+    /*!
+     * Logs the players ids, the order read lists them in. Throws
+     * std::invalid_argument if an id is negative, above Roster::MAX_ID or
+     * given twice.
+     */
+    explicit InputLog(std::vector<int> ids = {});
+
+    /*!
+     * The input push stores for one that was given, clamped to [-1, 1]. Feed
+     * the world quantized inputs if it's to play the same as the log.
+     */
+    static CycleInput quantize(CycleInput input);
+
+    /*!
+     * Appends a frame. Logged players missing from inputs are logged as
+     * having none, and are left out of it when read. Throws
+     * std::invalid_argument if inputs has a player that isn't logged.
+     */
+    void push(const PlayerInputs& inputs);
+    /*! Forgets frames from frames on. */
+    void truncate(size_t frames);
+
+    /*!
+     * Appends frames first to first + frames to out as 64 bit words: the
+     * frame and run counts, the end of each run as 32 bit frame counts, and
+     * each run's row. Throws std::out_of_range if the log isn't that long.
+     */
+    void write(size_t first, size_t frames, std::vector<uint64_t>& out) const;
+    /*!
+     * Appends frames that write wrote from a log of the same players. Throws
+     * std::invalid_argument, leaving the log alone, if data doesn't hold
+     * exactly that.
+     */
+    void append(const uint64_t* data, size_t words);
+
+    size_t frames() const;
+    /*!
+     * Overwrites out with frame's inputs, in the order of ids, leaving out
+     * players who had none. Finds the frame in O(log runs) and doesn't
+     * allocate once out has room for every player. Throws std::out_of_range if
+     * frame is past the end.
+     */
+    void read(size_t frame, PlayerInputs& out) const;
+
+    const std::vector<int>& ids() const;
+    /*! How many runs of unchanged input there are. */
+    size_t runs() const;
+    /*! Memory allocated for the log, chunks included. */
+    size_t bytes() const;
+
+   private:
+    struct Chunk {
+        // frame of the first run
+        size_t first;
+        // end of each run, as a frame count from first
+        std::vector<uint32_t> ends;
+        // _words per run
+        std::vector<uint64_t> rows;
+    };
+
+    // appends frames frames of row, extending the last run if it's the same
+    void push(const uint64_t* row, size_t frames);
+    // the chunk and run frame is in, which has to exist
+    void find(size_t frame, size_t& chunk, size_t& run) const;
+
+    std::vector<int> _ids;
+    // id to its place in a row, or -1
+    std::vector<int> _slots;
+    size_t _words;
+    std::vector<Chunk> _chunks;
+    size_t _frames;
+    // what push packs the frame into before comparing it with the last run
+    std::vector<uint64_t> _row;
+};
+
+}  // namespace lcycle
@@ -0,0 +1,115 @@
+#include "lcycle/JournalRollbackWorld.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "lcycle/RollbackWorld.hpp"
+#include "lcycle/World.hpp"
+#include "util/CircularBuffer.hpp"
+#include "util/FixedVector.hpp"
+
+namespace lcycle {
+
+// what one journal slot of w takes, arrays and all
+template <size_t N>
+static size_t slotBytes(const BasicWorld<N>& w) {
+    typename BasicWorld<N>::Checkpoint c;
+    w.save(c);
+    return sizeof(c) + c.heapBytes() + inputSlotBytes(w.players().size());
+}
+
+template <size_t N>
+BasicJournalRollbackWorld<N>::BasicJournalRollbackWorld(const BasicWorld<N>& w, double frameTime, int depth,
+                                                        size_t budget)
+    : _world(w),
+      _journal(rollbackSlots(depth, 0, slotBytes(w), budget)),
+      _inputs(_journal.capacity()),
+      _frameTime(frameTime),
+      _frame(0) {}
+
+template <size_t N>
+BasicJournalRollbackWorld<N>::BasicJournalRollbackWorld() : BasicJournalRollbackWorld(BasicWorld<N>()) {}
+
+template <size_t N>
+BasicWorld<N>* BasicJournalRollbackWorld<N>::latest() {
+    return &_world;
+}
+
+template <size_t N>
+bool BasicJournalRollbackWorld<N>::rollback(int frames) {
+    if (frames < 0 || _journal.size() < frames) return false;
+    if (frames == 0) return true;
+    for (int i = 1; i < frames; i++) {
+        _journal.remove();
+        _inputs.remove();
+    }
+    _world.restore(*_journal.tail());
+    _journal.remove();
+    _inputs.remove();
+    _frame -= frames;
+    return true;
+}
+
+template <size_t N>
+void BasicJournalRollbackWorld<N>::advance(const PlayerInputs& inputs) {
+    // once full, add() hands back the oldest checkpoint and inputs, whose storage gets reused
+    _world.save(*_journal.add());
+    _inputs.add(inputs);
+    _world.runFor(_frameTime, inputs);
+    _frame++;
+}
+
+template <size_t N>
+bool BasicJournalRollbackWorld<N>::correct(int64_t frame, int playerId, CycleInput input) {
+    const int64_t back = _frame - frame;
+    if (back < 1 || back > _journal.size()) return false;
+    _world.restore(*_journal.fromTail((int)back - 1));
+    // the checkpoints from frame on are still there, each one gets saved over
+    // again right before the world runs past it
+    for (int k = (int)back - 1; k >= 0; k--) {
+        PlayerInputs& inputs = *_inputs.fromTail(k);
+        setInput(inputs, playerId, input);
+        _world.save(*_journal.fromTail(k));
+        _world.runFor(_frameTime, inputs);
+    }
+    return true;
+}
+
+template <size_t N>
+int64_t BasicJournalRollbackWorld<N>::frame() const {
+    return _frame;
+}
+
+template <size_t N>
+uint64_t BasicJournalRollbackWorld<N>::stateHash(int framesAgo) const {
+    if (framesAgo == 0) return _world.stateHash();
+    const auto* c = _journal.fromTail(framesAgo - 1);
+    if (!c) throw std::out_of_range("No such frame to hash");
+    return c->hash;
+}
+
+template <size_t N>
+int BasicJournalRollbackWorld<N>::depth() const {
+    return _journal.capacity();
+}
+
+template <size_t N>
+int BasicJournalRollbackWorld<N>::history() const {
+    return _journal.size();
+}
+
+template <size_t N>
+size_t BasicJournalRollbackWorld<N>::bytes() const {
+    size_t bytes = _journal.bytes() + _inputs.bytes();
+    for (int k = 0; k < _journal.size(); k++) {
+        bytes += _journal.fromTail(k)->heapBytes() + util::heapBytes(*_inputs.fromTail(k));
+    }
+    return bytes;
+}
+
+template class BasicJournalRollbackWorld<0>;
+template class BasicJournalRollbackWorld<2>;
+template class BasicJournalRollbackWorld<4>;
+
+}  // namespace lcycle
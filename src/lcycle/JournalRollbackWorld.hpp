@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lcycle/RollbackWorld.hpp"
+#include "lcycle/World.hpp"
+#include "util/CircularBuffer.hpp"
+
+namespace lcycle {
+
+/*!
+ * Same interface as BasicRollbackWorld, but keeps a single world and a
+ * checkpoint per frame instead of a copy of the world per frame. Trails are
+ * append only between rollbacks, so a checkpoint just records how long they
+ * were, and rolling back truncates them. advance and rollback cost
+ * O(players) rather than O(segments). The world must not be compacted.
+ */
+template <size_t N>
+class BasicJournalRollbackWorld {
+   public:
+    /*!
+     * Keeps checkpoints for up to depth frames, fewer if they wouldn't fit in
+     * budget bytes (see bytes). Players only ever leave, so a checkpoint
+     * never needs more than one of w does. Throws std::invalid_argument if depth isn't
+     * positive or not even one checkpoint fits.
+     */
+    BasicJournalRollbackWorld(const BasicWorld<N>& w, double frameTime = 1.0 / 60.0,
+                              int depth = DEFAULT_ROLLBACK_DEPTH, size_t budget = SIZE_MAX);
+    BasicJournalRollbackWorld();
+
+    BasicWorld<N>* latest();
+    /*! Undoes the last frames advances, returns false without changing anything if there weren't that many. */
+    bool rollback(int frames);
+    void advance(const PlayerInputs& inputs);
+    /*!
+     * Replaces the input playerId advanced frame with, and the ones of every
+     * frame since, which were only predictions if frame's wasn't known yet,
+     * then plays them all again up to the frame it was at, restoring one
+     * checkpoint and running the world forward in place. Returns false
+     * without changing anything if frame is further back than rollback could
+     * go or isn't in the past.
+     */
+    bool correct(int64_t frame, int playerId, CycleInput input);
+    /*! How many frames the world is into the match: advances minus frames rolled back. */
+    int64_t frame() const;
+
+    /*!
+     * World::stateHash of the world framesAgo advances back, for comparing
+     * with a peer that reached that frame. Throws std::out_of_range if it's
+     * further back than rollback could go.
+     */
+    uint64_t stateHash(int framesAgo = 0) const;
+    /*! Most frames rollback can undo. */
+    int depth() const;
+    /*! How many frames rollback can undo right now, at most depth. */
+    int history() const;
+    /*!
+     * Memory the history takes on top of the world: the rings of checkpoints
+     * and inputs, and the arrays those point to on the heap. Checkpoints that
+     * were rolled back keep theirs for reuse, which isn't counted.
+     */
+    size_t bytes() const;
+
+   private:
+    BasicWorld<N> _world;
+    // state of _world before each of the last advances, newest at the tail
+    util::CircularBuffer<typename BasicWorld<N>::Checkpoint> _journal;
+    // what each of those advances was given, newest at the tail
+    util::CircularBuffer<PlayerInputs> _inputs;
+    double _frameTime;
+    // see frame()
+    int64_t _frame;
+};
+
+extern template class BasicJournalRollbackWorld<0>;
+extern template class BasicJournalRollbackWorld<2>;
+extern template class BasicJournalRollbackWorld<4>;
+
+using JournalRollbackWorld = BasicJournalRollbackWorld<0>;
+
+}  // namespace lcycle
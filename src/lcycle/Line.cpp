@@ -1,6 +1,8 @@
 #include "Line.hpp"
 #include <mathfu/glsl_mappings.h>
 
+#include <algorithm>
+
 namespace lcycle {
 
 Line::Line(const mathfu::vec2& start, const mathfu::vec2& end) : _s(start), _e(end) {}
@@ -41,19 +43,40 @@ bool Line::intersect(const Line& l1, const Line& l2) {
     vec2 y = l2.start();
     vec2 b = l2.end() - y;
 
-    //  a0(y1 - x1) - a1(y0 - x0)
-    //  -------------------------
-    //      a1 * b0 - a0 * b1
+    // x + lambda * a = y + mu * b, crossing both sides with b and a gives
+    //
+    //  lambda = cross(y - x, b) / cross(a, b)
+    //  mu     = cross(y - x, a) / cross(a, b)
+    //
+    // both are in (0, 1) iff each numerator n satisfies n * d > 0 and
+    // (d - n) * d > 0, so no division is needed
+
+    double wx = y.x() - x.x();
+    double wy = y.y() - x.y();
 
-    double denominator = (a.y() * b.x() - a.x() * b.y());
+    double d = (double)a.x() * b.y() - (double)a.y() * b.x();
 
     // parallel or coincident
-    if (denominator == 0.0) return false;
+    if (d == 0.0) return false;
+
+    double lambdaN = wx * b.y() - wy * b.x();
+    double muN = wx * a.y() - wy * a.x();
 
-    double mu = (a.x() * (y.y() - x.y()) - a.y() * (y.x() - x.x())) / denominator;
-    double lambda = (y.x() + mu * b.x() - x.x()) / a.x();
+    return lambdaN * d > 0.0 && (d - lambdaN) * d > 0.0 && muN * d > 0.0 && (d - muN) * d > 0.0;
+}
+
+static double pointDistance(const mathfu::vec2& p, const Line& l) {
+    mathfu::vec2 d = l.end() - l.start();
+    double lenSq = d.LengthSquared();
+    double t = lenSq > 0.0 ? mathfu::vec2::DotProduct(p - l.start(), d) / lenSq : 0.0;
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    return (p - (l.start() + (float)t * d)).Length();
+}
 
-    return 0.0 < mu && mu < 1.0 && 0.0 < lambda && lambda < 1.0;
+double Line::distance(const Line& a, const Line& b) {
+    if (intersect(a, b)) return 0.0;
+    return std::min(std::min(pointDistance(a.start(), b), pointDistance(a.end(), b)),
+                    std::min(pointDistance(b.start(), a), pointDistance(b.end(), a)));
 }
 
 }  // namespace lcycle
@@ -21,6 +21,8 @@ class Line {
     double lenSquared() const;
 
     static bool intersect(const Line& a, const Line& b);
+    /*! Shortest distance between any two points of a and b. */
+    static double distance(const Line& a, const Line& b);
 
    private:
     mathfu::vec2 _s, _e;
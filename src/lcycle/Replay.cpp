@@ -0,0 +1,148 @@
+#include "lcycle/Replay.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "lcycle/InputLog.hpp"
+#include "lcycle/Roster.hpp"
+#include "lcycle/World.hpp"
+#include "util/CircularBuffer.hpp"
+
+namespace lcycle {
+
+static std::vector<int> rosterIds(const Roster& roster) {
+    std::vector<int> ids;
+    for (const auto& p : roster) ids.push_back(p.id);
+    return ids;
+}
+
+template <size_t N>
+BasicReplay<N>::BasicReplay(const BasicWorld<N>& initial, double frameTime, int interval)
+    : _keyframes(), _log(rosterIds(initial.roster())), _frameTime(frameTime), _interval(interval), _frame() {
+    if (interval <= 0) throw std::invalid_argument("Keyframe interval must be positive");
+    _keyframes.push_back(initial);
+    _frame.reserve(_log.ids().size());
+}
+
+template <size_t N>
+BasicReplay<N>::BasicReplay(const BasicWorld<N>& initial, InputLog log, double frameTime, int interval)
+    : _keyframes(), _log(std::move(log)), _frameTime(frameTime), _interval(interval), _frame() {
+    if (interval <= 0) throw std::invalid_argument("Keyframe interval must be positive");
+    if (_log.ids() != rosterIds(initial.roster())) throw std::invalid_argument("Input log is of other players");
+    _keyframes.push_back(initial);
+    _frame.reserve(_log.ids().size());
+}
+
+template <size_t N>
+BasicReplay<N>::BasicReplay() : BasicReplay(BasicWorld<N>()) {}
+
+template <size_t N>
+void BasicReplay<N>::record(const PlayerInputs& inputs) {
+    _log.push(inputs);
+}
+
+template <size_t N>
+void BasicReplay<N>::truncate(size_t frames) {
+    if (frames >= _log.frames()) return;
+    _log.truncate(frames);
+    const size_t keep = std::min(_keyframes.size(), frames / _interval + 1);
+    _keyframes.erase(_keyframes.begin() + keep, _keyframes.end());
+}
+
+template <size_t N>
+void BasicReplay<N>::addKeyframe(const BasicWorld<N>& w) {
+    if (_keyframes.size() * _interval > _log.frames()) throw std::out_of_range("Replay isn't that long");
+    _keyframes.push_back(w);
+}
+
+template <size_t N>
+size_t BasicReplay<N>::frames() const {
+    return _log.frames();
+}
+
+template <size_t N>
+void BasicReplay<N>::inputs(size_t frame, PlayerInputs& out) const {
+    _log.read(frame, out);
+}
+
+template <size_t N>
+const InputLog& BasicReplay<N>::log() const {
+    return _log;
+}
+
+template <size_t N>
+const BasicWorld<N>& BasicReplay<N>::initial() const {
+    return _keyframes[0];
+}
+
+template <size_t N>
+double BasicReplay<N>::frameTime() const {
+    return _frameTime;
+}
+
+template <size_t N>
+int BasicReplay<N>::interval() const {
+    return _interval;
+}
+
+template <size_t N>
+size_t BasicReplay<N>::keyframes() const {
+    return _keyframes.size();
+}
+
+template <size_t N>
+void BasicReplay<N>::seek(size_t frame, BasicWorld<N>& w) {
+    if (frame > _log.frames()) throw std::out_of_range("Replay isn't that long");
+    const size_t k = std::min(frame / _interval, _keyframes.size() - 1);
+    w = _keyframes[k];
+    for (size_t f = k * _interval; f < frame; f++) play(f, w);
+}
+
+template <size_t N>
+void BasicReplay<N>::play(size_t frame, BasicWorld<N>& w) {
+    _log.read(frame, _frame);
+    w.runFor(_frameTime, _frame);
+    // only ever the next one, the ones before are all there
+    if ((frame + 1) % _interval == 0 && (frame + 1) / _interval == _keyframes.size()) _keyframes.push_back(w);
+}
+
+template <size_t N>
+BasicReplayCursor<N>::BasicReplayCursor(BasicReplay<N>& replay, int ring)
+    : _replay(&replay), _ring(ring), _last(0) {}
+
+template <size_t N>
+const BasicWorld<N>& BasicReplayCursor<N>::at(size_t frame) {
+    if (frame > _replay->frames()) throw std::out_of_range("Replay isn't that long");
+    if (_ring.size() > 0 && frame <= _last && _last - frame < (size_t)_ring.size()) {
+        return *_ring.fromTail((int)(_last - frame));
+    }
+    if (_ring.size() > 0 && frame == _last + 1) {
+        // once full, this overwrites the oldest world, reusing its storage
+        BasicWorld<N>* next = _ring.add(*_ring.tail());
+        _replay->play(_last++, *next);
+        return *next;
+    }
+    // anywhere else, fill the ring with the frames up to this one, so going
+    // back from here doesn't have to seek again for a while
+    while (_ring.remove()) {
+    }
+    const size_t first = frame + 1 >= (size_t)_ring.capacity() ? frame + 1 - _ring.capacity() : 0;
+    _replay->seek(first, *_ring.add());
+    for (_last = first; _last < frame; _last++) {
+        BasicWorld<N>* next = _ring.add(*_ring.tail());
+        _replay->play(_last, *next);
+    }
+    return *_ring.tail();
+}
+
+template class BasicReplay<0>;
+template class BasicReplay<2>;
+template class BasicReplay<4>;
+template class BasicReplayCursor<0>;
+template class BasicReplayCursor<2>;
+template class BasicReplayCursor<4>;
+
+}  // namespace lcycle
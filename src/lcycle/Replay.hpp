@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "lcycle/InputLog.hpp"
+#include "lcycle/World.hpp"
+#include "util/CircularBuffer.hpp"
+
+namespace lcycle {
+
+/*! Frames between replay keyframes unless asked otherwise, a second of play. */
+const int DEFAULT_KEYFRAME_INTERVAL = 60;
+
+/*!
+ * A recorded match: the world it started from and the inputs of every frame,
+ * kept in an InputLog of the players on the initial world's roster.
+ * Getting to a frame restores the nearest keyframe before it and plays only
+ * the inputs since. Keyframes are copies of the world every interval frames,
+ * made the first time playing goes past them, so recording costs nothing but
+ * the inputs, and they share trail and grid blocks with each other like any
+ * copies of a world do.
+ */
+template <size_t N>
+class BasicReplay {
+   public:
+    /*! Throws std::invalid_argument if interval isn't positive. */
+    explicit BasicReplay(const BasicWorld<N>& initial, double frameTime = 1.0 / 60.0,
+                         int interval = DEFAULT_KEYFRAME_INTERVAL);
+    /*!
+     * A replay of the frames in log, such as one read from a file. Throws
+     * std::invalid_argument if log isn't of the players on initial's roster,
+     * in roster order, or if interval isn't positive.
+     */
+    BasicReplay(const BasicWorld<N>& initial, InputLog log, double frameTime, int interval);
+    BasicReplay();
+
+    /*!
+     * Appends the inputs of the next frame, quantized the way InputLog does,
+     * so play them quantized too for the replay to match the match. Throws
+     * std::invalid_argument if inputs has a player that isn't on the roster.
+     */
+    void record(const PlayerInputs& inputs);
+    /*! Forgets frames from frames on, and the keyframes after them, for when the match is rolled back. */
+    void truncate(size_t frames);
+    /*!
+     * Adds the keyframe after keyframes() * interval() frames, which has to be
+     * the world playing would have made, say one read from a file. Throws
+     * std::out_of_range if the replay isn't that long.
+     */
+    void addKeyframe(const BasicWorld<N>& w);
+
+    /*! How many frames were recorded. */
+    size_t frames() const;
+    /*! Overwrites out with frame's inputs. Throws std::out_of_range if frame is past the end. */
+    void inputs(size_t frame, PlayerInputs& out) const;
+    const InputLog& log() const;
+    const BasicWorld<N>& initial() const;
+    double frameTime() const;
+    int interval() const;
+    /*! Keyframes made so far, counting the initial world. */
+    size_t keyframes() const;
+
+    /*!
+     * Sets w to the world after frame frames, playing fewer than interval
+     * frames if the keyframe before it was made already. Throws
+     * std::out_of_range if frame is past the end.
+     */
+    void seek(size_t frame, BasicWorld<N>& w);
+    /*! Plays frame on w, which has to be the world after frame frames, keeping a keyframe if one is due. */
+    void play(size_t frame, BasicWorld<N>& w);
+
+   private:
+    // _keyframes[k] is the world after k * _interval frames
+    std::vector<BasicWorld<N>> _keyframes;
+    InputLog _log;
+    double _frameTime;
+    int _interval;
+    // what play decodes a frame into, so it doesn't allocate
+    PlayerInputs _frame;
+};
+
+/*!
+ * Plays a replay back in either direction and from anywhere, keeping the
+ * worlds it played last in a ring. Stepping forward plays one frame, stepping
+ * back is served from the ring, which is refilled a ring's worth of frames at
+ * a time, so playing in reverse costs about 1 + interval / ring frames per
+ * frame. The replay has to outlive the cursor and mustn't be truncated.
+ */
+template <size_t N>
+class BasicReplayCursor {
+   public:
+    /*! Throws std::invalid_argument if ring isn't positive. */
+    explicit BasicReplayCursor(BasicReplay<N>& replay, int ring = DEFAULT_KEYFRAME_INTERVAL);
+
+    /*! The world after frame frames, valid until the next call. Throws std::out_of_range past the end. */
+    const BasicWorld<N>& at(size_t frame);
+
+   private:
+    BasicReplay<N>* _replay;
+    util::CircularBuffer<BasicWorld<N>> _ring;
+    // frame of the world at the ring's tail
+    size_t _last;
+};
+
+extern template class BasicReplay<0>;
+extern template class BasicReplay<2>;
+extern template class BasicReplay<4>;
+extern template class BasicReplayCursor<0>;
+extern template class BasicReplayCursor<2>;
+extern template class BasicReplayCursor<4>;
+
+using Replay = BasicReplay<0>;
+using ReplayCursor = BasicReplayCursor<0>;
+
+}  // namespace lcycle
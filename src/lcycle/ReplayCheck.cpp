@@ -0,0 +1,43 @@
+#include "lcycle/ReplayCheck.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "lcycle/Replay.hpp"
+#include "lcycle/World.hpp"
+
+namespace lcycle {
+
+template <size_t N>
+ReplayCheck checkReplay(const BasicReplay<N>& replay, const std::vector<std::pair<size_t, uint64_t>>& checksums) {
+    ReplayCheck check;
+    BasicWorld<N> w = replay.initial();
+    PlayerInputs inputs;
+    auto c = checksums.begin();
+    // against every checksum taken after frame frames
+    auto compare = [&](size_t frame) {
+        for (; c != checksums.end() && c->first == frame; c++) {
+            check.checksums++;
+            if (c->second == w.stateHash()) continue;
+            if (check.mismatches++ == 0) check.firstMismatch = frame;
+        }
+    };
+    compare(0);
+    for (size_t f = 0; f < replay.frames(); f++) {
+        replay.inputs(f, inputs);
+        w.runFor(replay.frameTime(), inputs);
+        compare(f + 1);
+    }
+    check.frames = replay.frames();
+    check.alive = w.players().size();
+    if (check.alive == 1) check.winner = w.players()[0].id;
+    return check;
+}
+
+template ReplayCheck checkReplay<0>(const BasicReplay<0>&, const std::vector<std::pair<size_t, uint64_t>>&);
+template ReplayCheck checkReplay<2>(const BasicReplay<2>&, const std::vector<std::pair<size_t, uint64_t>>&);
+template ReplayCheck checkReplay<4>(const BasicReplay<4>&, const std::vector<std::pair<size_t, uint64_t>>&);
+
+}  // namespace lcycle
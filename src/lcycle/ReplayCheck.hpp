@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "lcycle/Replay.hpp"
+#include "lcycle/World.hpp"
+
+namespace lcycle {
+
+/*! What playing a replay through again found. */
+struct ReplayCheck {
+    size_t frames = 0;
+    /*! Players alive at the end, and the id of the last one if that's all. */
+    size_t alive = 0;
+    int winner = -1;
+    /*! Checksums the world didn't match, and the frame of the first of them. */
+    size_t checksums = 0;
+    size_t mismatches = 0;
+    size_t firstMismatch = 0;
+};
+
+/*!
+ * Plays every frame of replay on a copy of its initial world with runFor,
+ * nothing else, comparing World::stateHash with the checksums recorded along
+ * with it, say by readReplay. checksums have to be in order of frame.
+ */
+template <size_t N>
+ReplayCheck checkReplay(const BasicReplay<N>& replay, const std::vector<std::pair<size_t, uint64_t>>& checksums);
+
+extern template ReplayCheck checkReplay<0>(const BasicReplay<0>&, const std::vector<std::pair<size_t, uint64_t>>&);
+extern template ReplayCheck checkReplay<2>(const BasicReplay<2>&, const std::vector<std::pair<size_t, uint64_t>>&);
+extern template ReplayCheck checkReplay<4>(const BasicReplay<4>&, const std::vector<std::pair<size_t, uint64_t>>&);
+
+}  // namespace lcycle
@@ -0,0 +1,334 @@
+#include "lcycle/ReplayFile.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mathfu/glsl_mappings.h>
+
+#include "lcycle/Cycle.hpp"
+#include "lcycle/InputLog.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/Roster.hpp"
+#include "lcycle/World.hpp"
+#include "lcycle/WorldSnapshot.hpp"
+#include "util/MappedFile.hpp"
+
+namespace lcycle {
+
+static uint64_t fnv(uint64_t h, const uint64_t* words, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        h ^= words[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// of everything in a chunk but the checksum itself
+static uint64_t checksum(const ReplayFile::ChunkHeader& c, const uint64_t* payload) {
+    uint64_t head[4];
+    std::memcpy(head, &c, sizeof(head));
+    return fnv(fnv(0xcbf29ce484222325ull, head, 4), payload, c.words);
+}
+
+// where the header's checksum is, in words
+static constexpr size_t HEADER_CHECKSUM = offsetof(ReplayFile::Header, checksum) / 8;
+static_assert(HEADER_CHECKSUM + 1 == sizeof(ReplayFile::Header) / 8, "header checksum is its last word");
+
+// the checksum of the header and roster in words words, skipping the checksum itself
+static uint64_t headerChecksum(const uint64_t* words, size_t n) {
+    const size_t after = HEADER_CHECKSUM + 1;
+    return fnv(fnv(0xcbf29ce484222325ull, words, HEADER_CHECKSUM), words + after, n - after);
+}
+
+// appends the bytes of v, zero padded to a whole number of words
+static void put(std::vector<uint64_t>& buf, const void* v, size_t bytes) {
+    const size_t at = buf.size();
+    buf.resize(at + (bytes + 7) / 8, 0);
+    if (bytes > 0) std::memcpy(buf.data() + at, v, bytes);
+}
+
+template <size_t N>
+BasicReplayWriter<N>::BasicReplayWriter(const std::string& path, const BasicWorld<N>& initial, double frameTime,
+                                        int chunkFrames, int keyframeInterval)
+    : _file(nullptr),
+      _log(),
+      _chunkFrames(chunkFrames),
+      _keyframeInterval(keyframeInterval),
+      _sent(0),
+      _hashes(),
+      _payload(),
+      _snapshot(),
+      _failed(false),
+      _last(),
+      _pool(1) {
+    if (chunkFrames <= 0) throw std::invalid_argument("Replay chunks must have frames");
+    if (keyframeInterval < 0) throw std::invalid_argument("Keyframe interval can't be negative");
+
+    std::vector<int> ids;
+    for (const auto& p : initial.roster()) ids.push_back(p.id);
+    _log = InputLog(ids);
+    _hashes.reserve(chunkFrames);
+    initial.snapshot(_snapshot);
+
+    const WorldSnapshot::Header& s = _snapshot.header();
+    const ReplayFile::Header h = {ReplayFile::MAGIC,
+                                  ReplayFile::VERSION,
+                                  (uint32_t)ids.size(),
+                                  s.kinematics,
+                                  s.size,
+                                  s.dashTime,
+                                  frameTime,
+                                  (uint32_t)chunkFrames,
+                                  (uint32_t)keyframeInterval,
+                                  0};
+    std::vector<uint64_t> buf;
+    put(buf, &h, sizeof(h));
+    for (const auto& p : initial.roster()) {
+        const auto& f = p.cycle.fixedState();
+        const ReplayFile::PlayerEntry e = {p.id,
+                                           (uint32_t)p.name.size(),
+                                           p.cycle.pos().x(),
+                                           p.cycle.pos().y(),
+                                           p.cycle.heading().x(),
+                                           p.cycle.heading().y(),
+                                           f.x,
+                                           f.y,
+                                           f.angle,
+                                           0,
+                                           {p.color.x(), p.color.y(), p.color.z(), p.color.w()},
+                                           {p.tColor.x(), p.tColor.y(), p.tColor.z(), p.tColor.w()}};
+        put(buf, &e, sizeof(e));
+    }
+    for (const auto& p : initial.roster()) put(buf, p.name.data(), p.name.size());
+    buf[HEADER_CHECKSUM] = headerChecksum(buf.data(), buf.size());
+
+    _file = std::fopen(path.c_str(), "wb");
+    if (!_file) throw std::runtime_error("Can't open " + path);
+    write(std::move(buf));
+    send(ReplayFile::ChunkKind::Keyframe, 0, initial.stateHash(), _snapshot.data(), (_snapshot.bytes() + 7) / 8);
+}
+
+template <size_t N>
+BasicReplayWriter<N>::~BasicReplayWriter() {
+    try {
+        close();
+    } catch (const std::runtime_error&) {
+    }
+}
+
+template <size_t N>
+void BasicReplayWriter<N>::record(const PlayerInputs& inputs, const BasicWorld<N>& after) {
+    _log.push(inputs);
+    _hashes.push_back(after.stateHash());
+    const size_t frames = _log.frames();
+    if (frames - _sent >= (size_t)_chunkFrames) flush();
+    if (_keyframeInterval > 0 && frames % _keyframeInterval == 0) {
+        // after the inputs leading up to it, so a file that has it can play to it
+        flush();
+        after.snapshot(_snapshot);
+        send(ReplayFile::ChunkKind::Keyframe, frames, after.stateHash(), _snapshot.data(), (_snapshot.bytes() + 7) / 8);
+    }
+}
+
+template <size_t N>
+void BasicReplayWriter<N>::truncate(size_t frames) {
+    if (frames >= _log.frames()) return;
+    _log.truncate(frames);
+    if (frames < _sent) {
+        _hashes.clear();
+        send(ReplayFile::ChunkKind::Truncate, frames, 0, nullptr, 0);
+        _sent = frames;
+    } else {
+        _hashes.resize(frames - _sent);
+    }
+}
+
+template <size_t N>
+size_t BasicReplayWriter<N>::frames() const {
+    return _log.frames();
+}
+
+template <size_t N>
+void BasicReplayWriter<N>::close() {
+    if (!_file) return;
+    flush();
+    if (_last.valid()) _last.wait();
+    const bool closed = std::fclose(_file) == 0;
+    _file = nullptr;
+    if (_failed || !closed) throw std::runtime_error("Can't write replay file");
+}
+
+template <size_t N>
+void BasicReplayWriter<N>::write(std::vector<uint64_t> buf) {
+    _last = _pool.submit([this, buf = std::move(buf)]() {
+        // a chunk after a torn one would never be read anyway
+        if (_failed) return;
+        if (std::fwrite(buf.data(), sizeof(uint64_t), buf.size(), _file) != buf.size() || std::fflush(_file) != 0) {
+            _failed = true;
+        }
+    });
+}
+
+template <size_t N>
+void BasicReplayWriter<N>::send(ReplayFile::ChunkKind kind, uint64_t frame, uint64_t hash, const void* payload,
+                                size_t words) {
+    if (!_file) throw std::runtime_error("Replay file is closed");
+    const uint64_t* p = static_cast<const uint64_t*>(payload);
+    ReplayFile::ChunkHeader c = {ReplayFile::CHUNK_MAGIC, (uint32_t)kind, frame, hash, words, 0};
+    c.checksum = checksum(c, p);
+    std::vector<uint64_t> buf;
+    buf.reserve(sizeof(c) / 8 + words);
+    put(buf, &c, sizeof(c));
+    buf.insert(buf.end(), p, p + words);
+    write(std::move(buf));
+}
+
+template <size_t N>
+void BasicReplayWriter<N>::flush() {
+    const size_t frames = _log.frames();
+    if (frames == _sent) return;
+    _payload.clear();
+    _log.write(_sent, frames - _sent, _payload);
+    send(ReplayFile::ChunkKind::Inputs, _sent, _hashes.back(), _payload.data(), _payload.size());
+    _sent = frames;
+    _hashes.clear();
+}
+
+template <size_t N>
+BasicReplay<N> readReplay(const std::string& path, ReplayFileInfo* info) {
+    util::MappedFile f(path);
+    return readReplay<N>(f.data(), f.size(), info);
+}
+
+template <size_t N>
+BasicReplay<N> readReplay(const void* data, size_t bytes, ReplayFileInfo* info) {
+    using mathfu::vec2;
+    using mathfu::vec4;
+
+    if (reinterpret_cast<uintptr_t>(data) % 8 != 0) throw std::invalid_argument("Replay isn't 8 byte aligned");
+    const unsigned char* bytesAt = static_cast<const unsigned char*>(data);
+    ReplayFile::Header h;
+    if (bytes < sizeof(h)) throw std::invalid_argument("Not a replay file");
+    std::memcpy(&h, data, sizeof(h));
+    if (h.magic != ReplayFile::MAGIC) throw std::invalid_argument("Not a replay file");
+    if (h.version != ReplayFile::VERSION) throw std::invalid_argument("Unsupported replay file version");
+    if ((bytes - sizeof(h)) / sizeof(ReplayFile::PlayerEntry) < h.players) {
+        throw std::invalid_argument("Corrupt replay header");
+    }
+
+    // the roster, with the names after it, all of which the checksum has to
+    // vouch for before anything is made of them
+    ReplayFile::PlayerEntry e;
+    size_t pos = sizeof(h) + h.players * sizeof(e);
+    for (uint32_t i = 0; i < h.players; i++) {
+        std::memcpy(&e, bytesAt + sizeof(h) + i * sizeof(e), sizeof(e));
+        const size_t padded = ((size_t)e.nameBytes + 7) / 8 * 8;
+        if (padded > bytes - pos) throw std::invalid_argument("Corrupt replay roster");
+        pos += padded;
+    }
+    if (headerChecksum(static_cast<const uint64_t*>(data), pos / 8) != h.checksum) {
+        throw std::invalid_argument("Corrupt replay header");
+    }
+    if (h.kinematics > (uint32_t)Kinematics::Fixed || !WorldSnapshot::validArena(h.size, h.dashTime) ||
+        !(h.frameTime > 0.0 && h.frameTime <= 1.0) || h.chunkFrames == 0) {
+        throw std::invalid_argument("Replay header is out of range");
+    }
+
+    std::vector<Player> players;
+    std::vector<int> ids;
+    pos = sizeof(h) + h.players * sizeof(e);
+    for (uint32_t i = 0; i < h.players; i++) {
+        std::memcpy(&e, bytesAt + sizeof(h) + i * sizeof(e), sizeof(e));
+        const size_t padded = ((size_t)e.nameBytes + 7) / 8 * 8;
+        if (e.id < 0 || e.id > Roster::MAX_ID) throw std::invalid_argument("Replay player id is out of range");
+        const Cycle c = Cycle::withHeading(vec2(e.px, e.py), vec2(e.hx, e.hy), {e.fx, e.fy, e.angle});
+        players.push_back({c, e.id, std::string(reinterpret_cast<const char*>(bytesAt + pos), e.nameBytes),
+                           vec4(e.color[0], e.color[1], e.color[2], e.color[3]),
+                           vec4(e.tColor[0], e.tColor[1], e.tColor[2], e.tColor[3])});
+        ids.push_back(e.id);
+        pos += padded;
+    }
+    const BasicWorld<N> world(h.size, h.dashTime, players, (Kinematics)h.kinematics);
+
+    ReplayFileInfo found;
+    InputLog log(ids);
+    std::vector<BasicWorld<N>> keyframes;
+    while (pos < bytes) {
+        ReplayFile::ChunkHeader c;
+        if (bytes - pos < sizeof(c)) break;
+        std::memcpy(&c, bytesAt + pos, sizeof(c));
+        const uint64_t* payload = reinterpret_cast<const uint64_t*>(bytesAt + pos + sizeof(c));
+        if (c.magic != ReplayFile::CHUNK_MAGIC || c.words > (bytes - pos - sizeof(c)) / 8 ||
+            checksum(c, payload) != c.checksum) {
+            break;
+        }
+
+        // anything that doesn't follow from the chunks before is where reading stops
+        bool ok = true;
+        try {
+            switch ((ReplayFile::ChunkKind)c.kind) {
+                case ReplayFile::ChunkKind::Inputs:
+                    ok = !keyframes.empty() && c.frame == log.frames();
+                    if (!ok) break;
+                    log.append(payload, c.words);
+                    found.checksums.push_back({log.frames(), c.hash});
+                    break;
+                case ReplayFile::ChunkKind::Keyframe: {
+                    ok = c.frame == keyframes.size() * h.keyframeInterval && c.frame == log.frames() &&
+                         (keyframes.empty() || h.keyframeInterval > 0);
+                    if (!ok) break;
+                    BasicWorld<N> k = world;
+                    k.load(WorldSnapshotView(payload, c.words * 8));
+                    ok = k.stateHash() == c.hash;
+                    if (ok) keyframes.push_back(std::move(k));
+                    break;
+                }
+                case ReplayFile::ChunkKind::Truncate:
+                    ok = !keyframes.empty() && c.frame <= log.frames();
+                    if (!ok) break;
+                    log.truncate(c.frame);
+                    if (h.keyframeInterval > 0) {
+                        keyframes.resize(std::min(keyframes.size(), (size_t)(c.frame / h.keyframeInterval + 1)));
+                    }
+                    while (!found.checksums.empty() && found.checksums.back().first > c.frame) {
+                        found.checksums.pop_back();
+                    }
+                    break;
+                default:
+                    ok = false;
+            }
+        } catch (const std::logic_error&) {
+            ok = false;
+        }
+        if (!ok) break;
+        found.chunks++;
+        pos += sizeof(c) + c.words * 8;
+    }
+    found.truncated = pos < bytes;
+    if (keyframes.empty()) throw std::invalid_argument("Replay file stops before its initial world");
+
+    const int interval = h.keyframeInterval > 0 ? (int)h.keyframeInterval : DEFAULT_KEYFRAME_INTERVAL;
+    BasicReplay<N> replay(keyframes[0], std::move(log), h.frameTime, interval);
+    for (size_t k = 1; k < keyframes.size(); k++) replay.addKeyframe(keyframes[k]);
+    if (info) *info = std::move(found);
+    return replay;
+}
+
+template class BasicReplayWriter<0>;
+template class BasicReplayWriter<2>;
+template class BasicReplayWriter<4>;
+template BasicReplay<0> readReplay<0>(const std::string&, ReplayFileInfo*);
+template BasicReplay<2> readReplay<2>(const std::string&, ReplayFileInfo*);
+template BasicReplay<4> readReplay<4>(const std::string&, ReplayFileInfo*);
+template BasicReplay<0> readReplay<0>(const void*, size_t, ReplayFileInfo*);
+template BasicReplay<2> readReplay<2>(const void*, size_t, ReplayFileInfo*);
+template BasicReplay<4> readReplay<4>(const void*, size_t, ReplayFileInfo*);
+
+}  // namespace lcycle
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lcycle/InputLog.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/World.hpp"
+#include "lcycle/WorldSnapshot.hpp"
+#include "util/MappedFile.hpp"
+#include "util/WorkerPool.hpp"
+
+namespace lcycle {
+
+/*!
+ * The replay file format. A header and the roster come first, then chunks
+ * that are only ever appended: the inputs of a run of frames along with the
+ * state hash after the last of them, keyframes as WorldSnapshots, and marks
+ * where the match was rolled back. The header carries a checksum of itself
+ * and the roster, and every chunk one of its payload, so a damaged header is
+ * refused outright and a file cut short by a crash reads up to its last
+ * complete chunk. Like snapshots, everything is little endian and 8 byte
+ * aligned.
+ */
+struct ReplayFile {
+    static constexpr uint32_t MAGIC = 0x4c435246;        // "LCRF"
+    static constexpr uint32_t CHUNK_MAGIC = 0x4c435243;  // "LCRC"
+    static constexpr uint32_t VERSION = 2;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t players;
+        // a Kinematics
+        uint32_t kinematics;
+        double size;
+        double dashTime;
+        double frameTime;
+        uint32_t chunkFrames;
+        // 0 if there are no keyframes but the initial world
+        uint32_t keyframeInterval;
+        // 64 bit FNV-1a over the words before it, the roster and the names
+        uint64_t checksum;
+    };
+
+    /*! A player on the roster, followed by the names of them all, each padded to 8 bytes. */
+    struct PlayerEntry {
+        int32_t id;
+        uint32_t nameBytes;
+        // where the player starts
+        float px, py;
+        float hx, hy;
+        int32_t fx, fy;
+        uint32_t angle;
+        uint32_t reserved;
+        float color[4];
+        float tColor[4];
+    };
+
+    enum class ChunkKind : uint32_t {
+        /*! InputLog::write of the frames from frame on, with hash the World::stateHash after them. */
+        Inputs = 1,
+        /*! The WorldSnapshot after frame frames, the first of which is the initial world. */
+        Keyframe = 2,
+        /*! The match was rolled back to frame frames and the frames after follow again. */
+        Truncate = 3,
+    };
+
+    struct ChunkHeader {
+        uint32_t magic;
+        // a ChunkKind
+        uint32_t kind;
+        uint64_t frame;
+        uint64_t hash;
+        uint64_t words;
+        // 64 bit FNV-1a over the words before it and the payload's
+        uint64_t checksum;
+    };
+};
+
+static_assert(std::is_trivially_copyable<ReplayFile::Header>::value, "");
+static_assert(std::is_trivially_copyable<ReplayFile::PlayerEntry>::value, "");
+static_assert(std::is_trivially_copyable<ReplayFile::ChunkHeader>::value, "");
+static_assert(sizeof(ReplayFile::Header) == 56, "replay header has padding");
+static_assert(sizeof(ReplayFile::PlayerEntry) == 72, "replay player has padding");
+static_assert(sizeof(ReplayFile::ChunkHeader) == 40, "replay chunk header has padding");
+
+/*! What readReplay found in a file besides the replay. */
+struct ReplayFileInfo {
+    /*! World::stateHash after frame frames, for every inputs chunk, in order of frame. */
+    std::vector<std::pair<size_t, uint64_t>> checksums;
+    size_t chunks = 0;
+    /*! Whether reading stopped before the end, at a torn or corrupt chunk. */
+    bool truncated = false;
+};
+
+/*!
+ * Streams a match to a replay file as it's played. Recording packs inputs
+ * into an InputLog and, every chunkFrames frames, hands the new chunk to a
+ * thread of its own that appends it to the file and flushes, so the game
+ * never waits on the disk and a crash loses at most a chunk. Keyframes, if
+ * keyframeInterval isn't 0, are snapshots taken by record itself, which is
+ * a copy of the world's arrays every so often.
+ */
+template <size_t N>
+class BasicReplayWriter {
+   public:
+    /*!
+     * Starts the file with the header, roster and initial world. Throws
+     * std::runtime_error if the file can't be created, or std::invalid_argument
+     * if chunkFrames isn't positive or keyframeInterval is negative.
+     */
+    BasicReplayWriter(const std::string& path, const BasicWorld<N>& initial, double frameTime = 1.0 / 60.0,
+                      int chunkFrames = 60, int keyframeInterval = 0);
+    BasicReplayWriter(const BasicReplayWriter&) = delete;
+    BasicReplayWriter& operator=(const BasicReplayWriter&) = delete;
+    /*! Closes the file, ignoring errors. */
+    ~BasicReplayWriter();
+
+    /*!
+     * Appends a frame's inputs, quantized like BasicReplay::record does, and
+     * after, the world they led to. Throws std::invalid_argument if inputs has
+     * a player that isn't on the roster.
+     */
+    void record(const PlayerInputs& inputs, const BasicWorld<N>& after);
+    /*! Forgets frames from frames on, writing a mark if they're on their way to the file already. */
+    void truncate(size_t frames);
+    size_t frames() const;
+
+    /*!
+     * Writes the frames since the last chunk and waits until everything is in
+     * the file. Throws std::runtime_error if any write failed.
+     */
+    void close();
+
+   private:
+    // queues buf to be appended to the file
+    void write(std::vector<uint64_t> buf);
+    void send(ReplayFile::ChunkKind kind, uint64_t frame, uint64_t hash, const void* payload, size_t words);
+    // sends the frames recorded since the last chunk, if any
+    void flush();
+
+    std::FILE* _file;
+    InputLog _log;
+    int _chunkFrames;
+    int _keyframeInterval;
+    // frames sent to the file so far
+    size_t _sent;
+    // World::stateHash after each frame not sent yet
+    std::vector<uint64_t> _hashes;
+    std::vector<uint64_t> _payload;
+    WorldSnapshot _snapshot;
+    // set by the writing thread
+    std::atomic<bool> _failed;
+    std::future<void> _last;
+    // last, so it's done writing before anything else goes
+    util::WorkerPool _pool;
+};
+
+/*!
+ * Reads a replay file up to its last complete chunk, with the keyframes it
+ * has, and the replay's keyframe interval set to theirs. Throws
+ * std::runtime_error if it can't be read, std::invalid_argument if it isn't a
+ * replay file, its header or roster is damaged or out of range, or it stops
+ * before the initial world, or std::length_error if it has more than N
+ * players.
+ */
+template <size_t N>
+BasicReplay<N> readReplay(const std::string& path, ReplayFileInfo* info = nullptr);
+/*! Same from a file's bytes, which have to be 8 byte aligned. */
+template <size_t N>
+BasicReplay<N> readReplay(const void* data, size_t bytes, ReplayFileInfo* info = nullptr);
+
+/*!
+ * Reads the replay file at path on the world specialized for its players,
+ * like the game plays them: BasicReplay<2> for up to two, BasicReplay<4> for
+ * up to four and BasicReplay<0> past that. Calls f with the replay and the
+ * ReplayFileInfo, so f has to take any of the three, and returns what it
+ * returns. Throws what readReplay does.
+ */
+template <typename F>
+decltype(auto) withReplay(const std::string& path, F&& f) {
+    util::MappedFile file(path);
+    ReplayFile::Header h = {};
+    // anything too short for a header fails in readReplay
+    if (file.size() >= sizeof(h)) std::memcpy(&h, file.data(), sizeof(h));
+    ReplayFileInfo info;
+    if (h.players <= 2) {
+        const BasicReplay<2> replay = readReplay<2>(file.data(), file.size(), &info);
+        return f(replay, info);
+    } else if (h.players <= 4) {
+        const BasicReplay<4> replay = readReplay<4>(file.data(), file.size(), &info);
+        return f(replay, info);
+    }
+    const BasicReplay<0> replay = readReplay<0>(file.data(), file.size(), &info);
+    return f(replay, info);
+}
+
+extern template class BasicReplayWriter<0>;
+extern template class BasicReplayWriter<2>;
+extern template class BasicReplayWriter<4>;
+extern template BasicReplay<0> readReplay<0>(const std::string&, ReplayFileInfo*);
+extern template BasicReplay<2> readReplay<2>(const std::string&, ReplayFileInfo*);
+extern template BasicReplay<4> readReplay<4>(const std::string&, ReplayFileInfo*);
+extern template BasicReplay<0> readReplay<0>(const void*, size_t, ReplayFileInfo*);
+extern template BasicReplay<2> readReplay<2>(const void*, size_t, ReplayFileInfo*);
+extern template BasicReplay<4> readReplay<4>(const void*, size_t, ReplayFileInfo*);
+
+using ReplayWriter = BasicReplayWriter<0>;
+
+}  // namespace lcycle
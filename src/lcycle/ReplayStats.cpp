@@ -0,0 +1,209 @@
+#include "lcycle/ReplayStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mathfu/glsl_mappings.h>
+
+#include "lcycle/Line.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/Trail.hpp"
+#include "lcycle/World.hpp"
+
+namespace lcycle {
+
+ReplayStats::ReplayStats(int cells, int binFrames)
+    : _cells(cells),
+      _binFrames(binFrames),
+      _matches(0),
+      _frames(0),
+      _deaths(),
+      _trails(),
+      _lengths(),
+      _entrants(),
+      _deathBins(),
+      _alive(),
+      _died(),
+      _inputs() {
+    if (cells <= 0) throw std::invalid_argument("Heatmaps need cells");
+    if (binFrames <= 0) throw std::invalid_argument("Bins need frames");
+    _deaths.resize((size_t)cells * cells);
+    _trails.resize((size_t)cells * cells);
+}
+
+template <typename T>
+T& ReplayStats::at(std::vector<T>& v, size_t i) {
+    if (i >= v.size()) v.resize(i + 1);
+    return v[i];
+}
+
+size_t ReplayStats::cell(const mathfu::vec2& pos, double size) const {
+    // the arena spans [-size / 2, size / 2] both ways
+    const int x = std::max(0, std::min(_cells - 1, (int)std::floor((pos.x() / size + 0.5) * _cells)));
+    const int y = std::max(0, std::min(_cells - 1, (int)std::floor((pos.y() / size + 0.5) * _cells)));
+    return (size_t)y * _cells + x;
+}
+
+void ReplayStats::addTrail(const Line& l, double size) {
+    // dashes are far shorter than a cell, anything longer is split so each
+    // piece is counted where it lies
+    const double len = l.len();
+    const int pieces = std::max(1, (int)std::ceil(len * _cells / size));
+    const mathfu::vec2 step = (l.end() - l.start()) / (float)pieces;
+    for (int i = 0; i < pieces; i++) _trails[cell(l.start() + step * (i + 0.5f), size)] += len / pieces;
+}
+
+template <size_t N>
+bool ReplayStats::tally(const BasicReplay<N>& replay, bool finishedOnly) {
+    BasicWorld<N> w = replay.initial();
+    const double size = w.size();
+    _died.clear();
+    for (size_t f = 0; f < replay.frames(); f++) {
+        _alive.clear();
+        for (const auto& p : w.players()) _alive.push_back({p.id, p.cycle.pos()});
+        replay.inputs(f, _inputs);
+        w.runFor(replay.frameTime(), _inputs);
+        if (w.players().size() == _alive.size()) continue;
+
+        // whoever's gone died this frame, about where they were before it
+        for (const auto& before : _alive) {
+            const auto& players = w.players();
+            const bool died = std::none_of(players.begin(), players.end(),
+                                           [&](const CycleState& p) { return p.id == before.first; });
+            if (!died) continue;
+            _died.push_back({cell(before.second, size), (size_t)w.roster().indexOf(before.first), f / _binFrames});
+        }
+    }
+
+    // nothing's counted until it's known the match is
+    if (finishedOnly && w.players().size() > 1) return false;
+    for (size_t place = 0; place < w.roster().size(); place++) {
+        at(_entrants, place)++;
+        at(_deathBins, place);
+    }
+    for (const auto& d : _died) {
+        _deaths[d.cell]++;
+        at(_deathBins[d.place], d.bin)++;
+    }
+    for (const auto& trail : w.trails()) {
+        for (size_t i = 0; i < trail.size(); i++) addTrail(trail[i], size);
+        for (const auto& run : trail.runs()) {
+            for (uint32_t k = 0; k < run.count; k++) addTrail(run.dash(k), size);
+        }
+    }
+    at(_lengths, replay.frames() / _binFrames)++;
+    _frames += replay.frames();
+    _matches++;
+    return true;
+}
+
+template <size_t N>
+void ReplayStats::add(const BasicReplay<N>& replay) {
+    tally(replay, false);
+}
+
+template <size_t N>
+bool ReplayStats::addIfFinished(const BasicReplay<N>& replay) {
+    return tally(replay, true);
+}
+
+void ReplayStats::merge(const ReplayStats& other) {
+    if (other._cells != _cells || other._binFrames != _binFrames) {
+        throw std::invalid_argument("Can only merge stats with the same cells and bins");
+    }
+    _matches += other._matches;
+    _frames += other._frames;
+    for (size_t i = 0; i < _deaths.size(); i++) _deaths[i] += other._deaths[i];
+    for (size_t i = 0; i < _trails.size(); i++) _trails[i] += other._trails[i];
+    for (size_t b = 0; b < other._lengths.size(); b++) at(_lengths, b) += other._lengths[b];
+    for (size_t place = 0; place < other._entrants.size(); place++) {
+        at(_entrants, place) += other._entrants[place];
+        auto& bins = at(_deathBins, place);
+        for (size_t b = 0; b < other._deathBins[place].size(); b++) at(bins, b) += other._deathBins[place][b];
+    }
+}
+
+void ReplayStats::writeCsv(const std::string& dir) const {
+    auto write = [&](const char* name, auto rows) {
+        const std::string path = dir + "/" + name;
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) throw std::runtime_error("Can't open " + path);
+        rows(f);
+        if (std::ferror(f) | std::fclose(f)) throw std::runtime_error("Can't write " + path);
+    };
+    write("deaths.csv", [&](std::FILE* f) {
+        for (int y = 0; y < _cells; y++) {
+            for (int x = 0; x < _cells; x++) {
+                std::fprintf(f, x ? ",%llu" : "%llu", (unsigned long long)_deaths[(size_t)y * _cells + x]);
+            }
+            std::fputc('\n', f);
+        }
+    });
+    write("trails.csv", [&](std::FILE* f) {
+        for (int y = 0; y < _cells; y++) {
+            for (int x = 0; x < _cells; x++) std::fprintf(f, x ? ",%.2f" : "%.2f", _trails[(size_t)y * _cells + x]);
+            std::fputc('\n', f);
+        }
+    });
+    write("lengths.csv", [&](std::FILE* f) {
+        std::fprintf(f, "frame,matches\n");
+        for (size_t b = 0; b < _lengths.size(); b++) {
+            std::fprintf(f, "%zu,%llu\n", b * _binFrames, (unsigned long long)_lengths[b]);
+        }
+    });
+    write("survival.csv", [&](std::FILE* f) {
+        std::fprintf(f, "frame");
+        for (size_t place = 0; place < _entrants.size(); place++) std::fprintf(f, ",place%zu", place);
+        std::fputc('\n', f);
+        // until the longest match is over
+        for (size_t b = 0; b <= _lengths.size(); b++) {
+            std::fprintf(f, "%zu", b * _binFrames);
+            for (size_t place = 0; place < _entrants.size(); place++) {
+                std::fprintf(f, ",%.4f", survival(place, b * _binFrames));
+            }
+            std::fputc('\n', f);
+        }
+    });
+}
+
+int ReplayStats::cells() const { return _cells; }
+
+int ReplayStats::binFrames() const { return _binFrames; }
+
+uint64_t ReplayStats::matches() const { return _matches; }
+
+uint64_t ReplayStats::frames() const { return _frames; }
+
+const std::vector<uint64_t>& ReplayStats::deaths() const { return _deaths; }
+
+const std::vector<double>& ReplayStats::trails() const { return _trails; }
+
+const std::vector<uint64_t>& ReplayStats::lengths() const { return _lengths; }
+
+const std::vector<uint64_t>& ReplayStats::entrants() const { return _entrants; }
+
+const std::vector<std::vector<uint64_t>>& ReplayStats::deathBins() const { return _deathBins; }
+
+double ReplayStats::survival(size_t place, uint64_t frames) const {
+    if (place >= _entrants.size() || _entrants[place] == 0) return 0.0;
+    const auto& bins = _deathBins[place];
+    uint64_t dead = 0;
+    for (size_t b = 0; b < std::min(bins.size(), (size_t)(frames / _binFrames)); b++) dead += bins[b];
+    return 1.0 - (double)dead / _entrants[place];
+}
+
+template void ReplayStats::add<0>(const BasicReplay<0>&);
+template void ReplayStats::add<2>(const BasicReplay<2>&);
+template void ReplayStats::add<4>(const BasicReplay<4>&);
+template bool ReplayStats::addIfFinished<0>(const BasicReplay<0>&);
+template bool ReplayStats::addIfFinished<2>(const BasicReplay<2>&);
+template bool ReplayStats::addIfFinished<4>(const BasicReplay<4>&);
+
+}  // namespace lcycle
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mathfu/glsl_mappings.h>
+
+#include "lcycle/Line.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/World.hpp"
+
+namespace lcycle {
+
+/*!
+ * Tallies over a corpus of replays, for balancing. Each match is played
+ * through with runFor and counted into
+ * - where cycles died and how much trail was laid where, on a cells by cells
+ *   grid stretched over the arena, whatever its size, rows going up from its
+ *   bottom edge,
+ * - how many matches lasted how long, in bins of binFrames frames,
+ * - when the player at each place on the roster died, which survival curves
+ *   are worked out from.
+ * Adding matches commutes, so each thread tallies on a ReplayStats of its own
+ * and they're merged once all are done.
+ */
+class ReplayStats {
+   public:
+    /*! Throws std::invalid_argument if cells or binFrames isn't positive. */
+    explicit ReplayStats(int cells = 64, int binFrames = 60);
+
+    template <size_t N>
+    void add(const BasicReplay<N>& replay);
+    /*!
+     * Same as add for a match that ended with at most one player left. One
+     * that was cut short first, which would count its survivors as living
+     * through it, is left out and false returned.
+     */
+    template <size_t N>
+    bool addIfFinished(const BasicReplay<N>& replay);
+    /*! Adds in other's tallies. Throws std::invalid_argument if its grid or bins differ. */
+    void merge(const ReplayStats& other);
+
+    /*!
+     * Writes deaths.csv and trails.csv, the grids a row per line, lengths.csv,
+     * matches by the frame their bin starts at, and survival.csv, the fraction
+     * of players at each place still alive at the start of each bin, into dir.
+     * Throws std::runtime_error if a file can't be written.
+     */
+    void writeCsv(const std::string& dir) const;
+
+    int cells() const;
+    int binFrames() const;
+    uint64_t matches() const;
+    uint64_t frames() const;
+    /*! cells * cells each, row after row. */
+    const std::vector<uint64_t>& deaths() const;
+    const std::vector<double>& trails() const;
+    const std::vector<uint64_t>& lengths() const;
+    /*!
+     * For each place on the roster, the matches it was in and its deaths in
+     * each bin, bin b holding those in frames b * binFrames to (b + 1) * binFrames.
+     */
+    const std::vector<uint64_t>& entrants() const;
+    const std::vector<std::vector<uint64_t>>& deathBins() const;
+    /*! The fraction of players at place still alive after frames frames, rounded down to a whole bin. */
+    double survival(size_t place, uint64_t frames) const;
+
+   private:
+    struct Death {
+        size_t cell;
+        size_t place;
+        size_t bin;
+    };
+
+    // plays replay through and counts it, unless finishedOnly and it wasn't
+    template <size_t N>
+    bool tally(const BasicReplay<N>& replay, bool finishedOnly);
+    // the grid cell pos is in, on an arena of size size
+    size_t cell(const mathfu::vec2& pos, double size) const;
+    void addTrail(const Line& l, double size);
+    // grows v to hold index i
+    template <typename T>
+    static T& at(std::vector<T>& v, size_t i);
+
+    int _cells;
+    int _binFrames;
+    uint64_t _matches;
+    uint64_t _frames;
+    std::vector<uint64_t> _deaths;
+    std::vector<double> _trails;
+    std::vector<uint64_t> _lengths;
+    std::vector<uint64_t> _entrants;
+    std::vector<std::vector<uint64_t>> _deathBins;
+    // tally's scratch, the players alive before the frame being played and
+    // where they were, and the deaths so far
+    std::vector<std::pair<int, mathfu::vec2>> _alive;
+    std::vector<Death> _died;
+    PlayerInputs _inputs;
+};
+
+extern template void ReplayStats::add<0>(const BasicReplay<0>&);
+extern template void ReplayStats::add<2>(const BasicReplay<2>&);
+extern template void ReplayStats::add<4>(const BasicReplay<4>&);
+extern template bool ReplayStats::addIfFinished<0>(const BasicReplay<0>&);
+extern template bool ReplayStats::addIfFinished<2>(const BasicReplay<2>&);
+extern template bool ReplayStats::addIfFinished<4>(const BasicReplay<4>&);
+
+}  // namespace lcycle
@@ -1,36 +1,266 @@
 #include "lcycle/RollbackWorld.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
 #include "lcycle/World.hpp"
 #include "util/CircularBuffer.hpp"
+#include "util/FixedVector.hpp"
+#include "util/WorkerPool.hpp"
 
 namespace lcycle {
 
-RollbackWorld::RollbackWorld(const World& w) : _buf() {
-    for (int i = 0; i < 64; i++) {
-        *_buf.add() = w;
+int rollbackSlots(int depth, int current, size_t slotSize, size_t budget) {
+    if (depth < 0 || depth + current < 1) throw std::invalid_argument("Rollback depth is too small");
+    size_t slots = std::min((size_t)(depth + current), budget / slotSize);
+    if (slots < (size_t)std::max(current, 1)) throw std::invalid_argument("Rollback memory budget is too small");
+    return (int)slots;
+}
+
+size_t inputSlotBytes(size_t players) {
+    return sizeof(PlayerInputs) + players * sizeof(PlayerInputs::value_type);
+}
+
+// which of the three ways an input steers, rounding anything in between
+static int direction(const CycleInput& input) {
+    return input.turnDir < -0.5f ? -1 : input.turnDir > 0.5f ? 1 : 0;
+}
+
+static bool sameInputs(const PlayerInputs& a, const PlayerInputs& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].first != b[i].first || a[i].second.turnDir != b[i].second.turnDir) return false;
+    }
+    return true;
+}
+
+void setInput(PlayerInputs& inputs, int id, CycleInput input) {
+    for (auto& in : inputs) {
+        if (in.first == id) {
+            in.second = input;
+            return;
+        }
+    }
+    inputs.push_back({id, input});
+}
+
+std::vector<PlayerInputs> alternativeInputs(const PlayerInputs& predicted, const std::vector<int>& ids) {
+    std::vector<PlayerInputs> branches;
+    for (int id : ids) {
+        for (size_t i = 0; i < predicted.size(); i++) {
+            if (predicted[i].first != id) continue;
+            for (int dir : {-1, 0, 1}) {
+                if (dir == direction(predicted[i].second)) continue;
+                branches.push_back(predicted);
+                branches.back()[i].second.turnDir = (float)dir;
+            }
+        }
     }
+    return branches;
 }
 
-RollbackWorld::RollbackWorld() : RollbackWorld::RollbackWorld(World()) {}
+// frames probeFrameBytes averages over, enough that the odd one that clones
+// grid blocks doesn't throw it off much
+static const int PROBE_FRAMES = 8;
+
+// what a frame of history over w is likely to hold besides its slot, from
+// playing a few frames without input on a copy
+template <size_t N>
+static size_t probeFrameBytes(const BasicWorld<N>& w, double frameTime) {
+    BasicWorld<N> prev(w), cur;
+    prev.runFor(frameTime, {});
+    size_t bytes = 0;
+    for (int i = 0; i < PROBE_FRAMES; i++) {
+        cur = prev;
+        cur.runFor(frameTime, {});
+        bytes += prev.unsharedBytes(cur);
+        std::swap(prev, cur);
+    }
+    return bytes / PROBE_FRAMES;
+}
+
+template <size_t N>
+BasicRollbackWorld<N>::BasicRollbackWorld(const BasicWorld<N>& w, double frameTime, int depth, size_t budget)
+    : _buf(rollbackSlots(depth, 1,
+                         sizeof(BasicWorld<N>) + inputSlotBytes(w.players().size()) + sizeof(size_t) +
+                             probeFrameBytes(w, frameTime),
+                         budget)),
+      _inputs(std::max(1, _buf.capacity() - 1)),
+      _frameBytes(_buf.capacity()),
+      _historyBytes(0),
+      _budget(budget),
+      _frameTime(frameTime),
+      _frame(0),
+      _branchFrame(0),
+      _branches() {
+    _buf.add(w);
+    _frameBytes.add(0);
+}
 
-World* RollbackWorld::latest() { return _buf.tail(); }
+template <size_t N>
+BasicRollbackWorld<N>::BasicRollbackWorld() : BasicRollbackWorld(BasicWorld<N>()) {}
 
-bool RollbackWorld::rollback(int frames) {
+template <size_t N>
+BasicWorld<N>* BasicRollbackWorld<N>::latest() {
+    return _buf.tail();
+}
+
+template <size_t N>
+bool BasicRollbackWorld<N>::rollback(int frames) {
     if (_buf.size() > frames) {
         for (int i = 0; i < frames; i++) {
-            _buf.remove();
+            dropNewest();
+            _inputs.remove();
         }
+        _frame -= frames;
+        // the frame the branches started from is going to be played again
+        if (_frame < _branchFrame) dropBranches();
         return true;
     }
     return false;
 }
 
-void RollbackWorld::advance(const World::PlayerInputs& inputs) {
-    constexpr double duration = 1.0 / 60.0;
-    World* cur = _buf.tail();
-    World* next = _buf.add();
-    *next = *cur;
-    next->runFor(duration, inputs);
+template <size_t N>
+void BasicRollbackWorld<N>::advance(const PlayerInputs& inputs) {
+    // once full, the oldest inputs' storage gets reused
+    _inputs.add(inputs);
+    play(inputs);
+}
+
+template <size_t N>
+bool BasicRollbackWorld<N>::correct(int64_t frame, int playerId, CycleInput input) {
+    const int64_t back = _frame - frame;
+    if (back < 1 || back >= _buf.size()) return false;
+    for (int k = (int)back - 1; k >= 0; k--) setInput(*_inputs.fromTail(k), playerId, input);
+    for (int k = 0; k < back; k++) dropNewest();
+    _frame = frame;
+    if (_frame < _branchFrame) dropBranches();
+    for (int k = (int)back - 1; k >= 0; k--) play(*_inputs.fromTail(k));
+    return true;
+}
+
+template <size_t N>
+int64_t BasicRollbackWorld<N>::frame() const {
+    return _frame;
 }
 
+template <size_t N>
+void BasicRollbackWorld<N>::play(const PlayerInputs& inputs) {
+    // once full, the oldest world's slot goes to the new one
+    if (_frameBytes.size() == _frameBytes.capacity()) _historyBytes -= *_frameBytes.head();
+    bool played = false;
+    if (_frame == _branchFrame) {
+        for (size_t i = 0; i < _branches.size() && !played; i++) {
+            Branch& b = *_branches[i];
+            if (!sameInputs(b.inputs, inputs)) continue;
+            b.done.get();
+            // its world is the frame played already, and moving it in only
+            // moves pointers to trail and grid blocks
+            _buf.add(std::move(b.world));
+            _branches.erase(_branches.begin() + i);
+            played = true;
+        }
+    }
+    if (!played) {
+        BasicWorld<N>* cur = _buf.tail();
+        BasicWorld<N>* next = _buf.add(*cur);
+        next->runFor(_frameTime, inputs);
+    }
+    _frame++;
+
+    // the world before is history now, holding whatever the new one cloned
+    // away from it
+    *_frameBytes.add() = 0;
+    size_t& prev = *_frameBytes.fromTail(1);
+    prev = _buf.fromTail(1)->unsharedBytes(*_buf.tail());
+    _historyBytes += prev;
+    // the rings were paid for up front, the worlds in them get what's left
+    while (_buf.size() > 1 && bytes() > _budget) dropOldest();
+}
+
+// what a dropped world's slot is left holding, so the blocks only it had go
+// now rather than when the slot comes around again. Copies of it share all
+// of its blocks, so they hold nothing but their own arrays.
+template <size_t N>
+static const BasicWorld<N>& emptyWorld() {
+    static const BasicWorld<N> empty;
+    return empty;
+}
+
+template <size_t N>
+void BasicRollbackWorld<N>::dropNewest() {
+    *_buf.tail() = emptyWorld<N>();
+    _buf.remove();
+    _frameBytes.remove();
+    // the world before is the latest again
+    _historyBytes -= *_frameBytes.tail();
+    *_frameBytes.tail() = 0;
+}
+
+template <size_t N>
+void BasicRollbackWorld<N>::dropOldest() {
+    // memory's short, so its working arrays go too
+    *_buf.head() = BasicWorld<N>(emptyWorld<N>());
+    _buf.removeHead();
+    _historyBytes -= *_frameBytes.head();
+    _frameBytes.removeHead();
+    // the inputs that led out of it go with it
+    if (_inputs.size() >= _buf.size()) _inputs.removeHead();
+}
+
+template <size_t N>
+void BasicRollbackWorld<N>::speculate(const std::vector<PlayerInputs>& branches, util::WorkerPool& pool) {
+    dropBranches();
+    _branchFrame = _frame;
+    const double frameTime = _frameTime;
+    for (const auto& inputs : branches) {
+        // copied here, sharing blocks with the latest world, which every
+        // branch then clones before writing to
+        auto b = std::make_shared<Branch>(Branch{inputs, *_buf.tail(), {}});
+        b->done = pool.submit([b, frameTime]() { b->world.runFor(frameTime, b->inputs); });
+        _branches.push_back(std::move(b));
+    }
+}
+
+template <size_t N>
+void BasicRollbackWorld<N>::dropBranches() {
+    // wait rather than abandon them, so nothing else can write to blocks the
+    // branches are still reading
+    for (auto& b : _branches) b->done.wait();
+    _branches.clear();
+}
+
+template <size_t N>
+uint64_t BasicRollbackWorld<N>::stateHash(int framesAgo) const {
+    const BasicWorld<N>* w = _buf.fromTail(framesAgo);
+    if (!w) throw std::out_of_range("No such frame to hash");
+    return w->stateHash();
+}
+
+template <size_t N>
+int BasicRollbackWorld<N>::depth() const {
+    return _buf.capacity() - 1;
+}
+
+template <size_t N>
+int BasicRollbackWorld<N>::history() const {
+    return _buf.size() - 1;
+}
+
+template <size_t N>
+size_t BasicRollbackWorld<N>::bytes() const {
+    size_t bytes = _buf.bytes() + _inputs.bytes() + _frameBytes.bytes() + _historyBytes;
+    for (int k = 0; k < _inputs.size(); k++) bytes += util::heapBytes(*_inputs.fromTail(k));
+    return bytes;
+}
+
+template class BasicRollbackWorld<0>;
+template class BasicRollbackWorld<2>;
+template class BasicRollbackWorld<4>;
+
 }  // namespace lcycle
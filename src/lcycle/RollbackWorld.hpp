@@ -1,21 +1,148 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
 #include "lcycle/World.hpp"
 #include "util/CircularBuffer.hpp"
+#include "util/WorkerPool.hpp"
 
 namespace lcycle {
 
-class RollbackWorld {
+/*! Frames a rollback world can undo unless asked otherwise. */
+const int DEFAULT_ROLLBACK_DEPTH = 63;
+
+/*!
+ * How many slots of slotSize bytes a rollback world keeps for depth frames of
+ * history plus current more, cutting history short to stay within budget
+ * bytes. Throws std::invalid_argument if that leaves no slots, or fewer than
+ * current.
+ */
+int rollbackSlots(int depth, int current, size_t slotSize, size_t budget);
+
+/*! Bytes a ring slot holding inputs for this many players takes, counting the array it points to. */
+size_t inputSlotBytes(size_t players);
+
+/*! Sets the input of player id, adding one if inputs has none. */
+void setInput(PlayerInputs& inputs, int id, CycleInput input);
+
+/*!
+ * The corrections to predicted most worth speculating on: each of the players
+ * ids turning one of the two ways they weren't predicted to, one player at a
+ * time, since players seldom change direction on the same frame. Players
+ * missing from predicted are skipped.
+ */
+std::vector<PlayerInputs> alternativeInputs(const PlayerInputs& predicted, const std::vector<int>& ids);
+
+/*!
+ * Keeps a copy of the world for each of the last depth frames and the
+ * current one. A LAN session gets by with a handful of frames, a link with a
+ * lot of latency may need a few seconds' worth.
+ *
+ * It can also speculate: play the next frame ahead of time with inputs that
+ * might yet arrive, on worker threads and next to the main timeline, so that
+ * a correction matching one of them takes the finished world instead of
+ * simulating the frame again.
+ */
+template <size_t N>
+class BasicRollbackWorld {
    public:
-    RollbackWorld(const World& w);
-    RollbackWorld();
+    /*!
+     * Keeps up to depth frames within budget bytes (see bytes). The rings are
+     * allocated up front, with fewer slots if depth frames wouldn't fit going
+     * by a few played on a copy of w. What each frame really holds is counted
+     * as it's played, and the oldest frames are dropped once that's over
+     * budget. Throws std::invalid_argument if depth is negative or not even
+     * the current world would fit.
+     */
+    BasicRollbackWorld(const BasicWorld<N>& w, double frameTime = 1.0 / 60.0, int depth = DEFAULT_ROLLBACK_DEPTH,
+                       size_t budget = SIZE_MAX);
+    BasicRollbackWorld();
 
-    World* latest();
+    BasicWorld<N>* latest();
+    /*! Undoes the last frames advances, returns false without changing anything if there weren't that many. */
     bool rollback(int frames);
-    void advance(const World::PlayerInputs& inputs);
+    /*! Plays a frame, or takes the world of a speculated branch with the same inputs if there is one. */
+    void advance(const PlayerInputs& inputs);
+    /*!
+     * Replaces the input playerId advanced frame with, and the ones of every
+     * frame since, which were only predictions if frame's wasn't known yet,
+     * then plays them all again up to the frame it was at. Returns false
+     * without changing anything if frame is further back than rollback could
+     * go or isn't in the past.
+     */
+    bool correct(int64_t frame, int playerId, CycleInput input);
+    /*! How many frames the latest world is into the match: advances minus frames rolled back. */
+    int64_t frame() const;
+    /*!
+     * Starts playing a frame from the latest world for each of branches on
+     * pool, replacing any branches from before. They stay around until
+     * rollback goes back past the frame they started from, and advance from
+     * that frame with one of their inputs waits for it if need be and takes
+     * its world. The latest world mustn't be changed other than through this
+     * class while they run, reading it is fine.
+     */
+    void speculate(const std::vector<PlayerInputs>& branches, util::WorkerPool& pool);
+
+    /*!
+     * World::stateHash of the world framesAgo advances back, for comparing
+     * with a peer that reached that frame. Throws std::out_of_range if it's
+     * further back than rollback could go.
+     */
+    uint64_t stateHash(int framesAgo = 0) const;
+    /*! Most frames rollback can undo. */
+    int depth() const;
+    /*! How many frames rollback can undo right now, at most depth. */
+    int history() const;
+    /*!
+     * Memory the history takes on top of the latest world: the rings, the
+     * inputs' arrays, and whatever each older world holds that the one after
+     * it doesn't share (see World::unsharedBytes). Branches being speculated
+     * aren't counted, and neither are arrays a dropped world leaves in its
+     * slot for the next one.
+     */
+    size_t bytes() const;
 
    private:
-    util::CircularBuffer<World, 64> _buf;
+    // the job playing a branch holds on to it too, so dropping one never
+    // frees a world a worker is still playing
+    struct Branch {
+        PlayerInputs inputs;
+        BasicWorld<N> world;
+        std::future<void> done;
+    };
+
+    // advances, taking a branch if one matches
+    void play(const PlayerInputs& inputs);
+    // take the latest or the oldest world out of the ring, emptying its slot
+    void dropNewest();
+    void dropOldest();
+    void dropBranches();
+
+    util::CircularBuffer<BasicWorld<N>> _buf;
+    // what each world in _buf but the oldest was advanced with, newest at the tail
+    util::CircularBuffer<PlayerInputs> _inputs;
+    // parallel to _buf, what each world holds that the one after it doesn't
+    // share, so what dropping it would free. 0 for the latest.
+    util::CircularBuffer<size_t> _frameBytes;
+    // sum of _frameBytes
+    size_t _historyBytes;
+    size_t _budget;
+    double _frameTime;
+    // see frame()
+    int64_t _frame;
+    // what the branches were speculated from
+    int64_t _branchFrame;
+    std::vector<std::shared_ptr<Branch>> _branches;
 };
 
+extern template class BasicRollbackWorld<0>;
+extern template class BasicRollbackWorld<2>;
+extern template class BasicRollbackWorld<4>;
+
+using RollbackWorld = BasicRollbackWorld<0>;
+
 }  // namespace lcycle
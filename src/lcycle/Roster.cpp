@@ -0,0 +1,38 @@
+#include "Roster.hpp"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lcycle {
+
+Roster::Roster() : _players(), _idToIdx() {}
+
+Roster::Roster(std::vector<Player> players) : _players(std::move(players)), _idToIdx() {
+    for (size_t i = 0; i < _players.size(); i++) {
+        const int id = _players[i].id;
+        if (id < 0) throw std::invalid_argument("Player ids must not be negative");
+        if (id > MAX_ID) throw std::invalid_argument("Player id is too large");
+        if ((size_t)id >= _idToIdx.size()) _idToIdx.resize(id + 1, -1);
+        if (_idToIdx[id] >= 0) throw std::invalid_argument("Player ids must be unique");
+        _idToIdx[id] = i;
+    }
+}
+
+size_t Roster::size() const { return _players.size(); }
+
+const Player& Roster::operator[](size_t idx) const { return _players[idx]; }
+
+std::vector<Player>::const_iterator Roster::begin() const { return _players.begin(); }
+
+std::vector<Player>::const_iterator Roster::end() const { return _players.end(); }
+
+int Roster::indexOf(int id) const { return id >= 0 && (size_t)id < _idToIdx.size() ? _idToIdx[id] : -1; }
+
+const Player& Roster::byId(int id) const {
+    int idx = indexOf(id);
+    if (idx < 0) throw std::out_of_range("No player with this id");
+    return _players[idx];
+}
+
+}  // namespace lcycle
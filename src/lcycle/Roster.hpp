@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <mathfu/glsl_mappings.h>
+
+#include "Cycle.hpp"
+
+namespace lcycle {
+
+/*! Everything about a player that is fixed when a match starts. */
+struct Player {
+    using Color = mathfu::vec4;
+
+    // where the player starts
+    Cycle cycle;
+    int id;
+    std::string name;
+    Color color;
+    Color tColor;
+};
+
+/*!
+ * The players of a match, in the order their trails are numbered. Never
+ * changes once built, so worlds share one roster and only keep the state of
+ * the cycles still alive, looking everything else up here by id.
+ */
+class Roster {
+   public:
+    /*! The largest id a player may have, since players are looked up by id in tables as long as the largest. */
+    static constexpr int MAX_ID = 1 << 16;
+
+    Roster();
+    /*! Throws std::invalid_argument if an id is negative, above MAX_ID or taken twice. */
+    explicit Roster(std::vector<Player> players);
+
+    size_t size() const;
+    const Player& operator[](size_t idx) const;
+    std::vector<Player>::const_iterator begin() const;
+    std::vector<Player>::const_iterator end() const;
+
+    /*! Index of the player with this id, or -1. */
+    int indexOf(int id) const;
+    /*! Throws std::out_of_range if no player has this id. */
+    const Player& byId(int id) const;
+
+   private:
+    std::vector<Player> _players;
+    std::vector<int> _idToIdx;
+};
+
+}  // namespace lcycle
@@ -0,0 +1,135 @@
+#include "SegmentBatch.hpp"
+
+#include <vectorial/simd4f.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Line.hpp"
+
+namespace lcycle {
+
+namespace {
+
+struct LineLanes {
+    simd4f x0, y0, dx, dy;
+};
+
+LineLanes splat(const Line& l) {
+    return {simd4f_splat(l.start().x()), simd4f_splat(l.start().y()), simd4f_splat(l.end().x() - l.start().x()),
+            simd4f_splat(l.end().y() - l.start().y())};
+}
+
+// division free version of Line::intersect: with d = cross(a, b), both
+// parameters lie strictly inside (0, 1) iff t * d and (d - t) * d are positive
+// for each of their numerators t. d == 0 makes every product 0, so parallel
+// segments never hit.
+unsigned hit4(const LineLanes& l, const float* sx, const float* sy, const float* ex, const float* ey) {
+    simd4f yx = simd4f_uload4(sx);
+    simd4f yy = simd4f_uload4(sy);
+    simd4f bx = simd4f_sub(simd4f_uload4(ex), yx);
+    simd4f by = simd4f_sub(simd4f_uload4(ey), yy);
+    simd4f wx = simd4f_sub(yx, l.x0);
+    simd4f wy = simd4f_sub(yy, l.y0);
+
+    simd4f d = simd4f_sub(simd4f_mul(l.dx, by), simd4f_mul(l.dy, bx));
+    simd4f tn = simd4f_sub(simd4f_mul(wx, by), simd4f_mul(wy, bx));
+    simd4f un = simd4f_sub(simd4f_mul(wx, l.dy), simd4f_mul(wy, l.dx));
+
+    simd4f m = simd4f_min(simd4f_min(simd4f_mul(tn, d), simd4f_mul(simd4f_sub(d, tn), d)),
+                          simd4f_min(simd4f_mul(un, d), simd4f_mul(simd4f_sub(d, un), d)));
+
+    float out[4];
+    simd4f_ustore4(m, out);
+    return (out[0] > 0.0f) | (out[1] > 0.0f) << 1 | (out[2] > 0.0f) << 2 | (out[3] > 0.0f) << 3;
+}
+
+// copies the last n % 4 segments into zero padded lanes
+unsigned hitTail(const LineLanes& l, const float* sx, const float* sy, const float* ex, const float* ey, size_t n) {
+    float t[4][4] = {};
+    for (size_t i = 0; i < n; i++) {
+        t[0][i] = sx[i];
+        t[1][i] = sy[i];
+        t[2][i] = ex[i];
+        t[3][i] = ey[i];
+    }
+    return hit4(l, t[0], t[1], t[2], t[3]);
+}
+
+}  // namespace
+
+void intersectMask(const Line& line, const float* sx, const float* sy, const float* ex, const float* ey, size_t n,
+                   uint32_t* mask) {
+    const LineLanes l = splat(line);
+    for (size_t w = 0; w < (n + 31) / 32; w++) mask[w] = 0;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        mask[i / 32] |= hit4(l, sx + i, sy + i, ex + i, ey + i) << (i % 32);
+    }
+    if (i < n) {
+        mask[i / 32] |= hitTail(l, sx + i, sy + i, ex + i, ey + i, n - i) << (i % 32);
+    }
+}
+
+bool intersectAny(const Line& line, const float* sx, const float* sy, const float* ex, const float* ey, size_t n) {
+    const LineLanes l = splat(line);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        if (hit4(l, sx + i, sy + i, ex + i, ey + i)) return true;
+    }
+    return i < n && hitTail(l, sx + i, sy + i, ex + i, ey + i, n - i);
+}
+
+SegmentBatch::SegmentBatch() : _sx(), _sy(), _ex(), _ey(), _size(0) {}
+
+void SegmentBatch::clear() {
+    _sx.clear();
+    _sy.clear();
+    _ex.clear();
+    _ey.clear();
+    _size = 0;
+}
+
+void SegmentBatch::reserve(size_t segments) {
+    segments = (segments + 3) / 4 * 4;
+    _sx.reserve(segments);
+    _sy.reserve(segments);
+    _ex.reserve(segments);
+    _ey.reserve(segments);
+}
+
+void SegmentBatch::push(const Line& line) { push(line.start().x(), line.start().y(), line.end().x(), line.end().y()); }
+
+void SegmentBatch::push(float sx, float sy, float ex, float ey) {
+    if (_size % 4 == 0) {
+        // open a new block of 4 lanes, unused ones stay degenerate
+        _sx.resize(_size + 4, 0.0f);
+        _sy.resize(_size + 4, 0.0f);
+        _ex.resize(_size + 4, 0.0f);
+        _ey.resize(_size + 4, 0.0f);
+    }
+    _sx[_size] = sx;
+    _sy[_size] = sy;
+    _ex[_size] = ex;
+    _ey[_size] = ey;
+    _size++;
+}
+
+size_t SegmentBatch::size() const { return _size; }
+
+size_t SegmentBatch::heapBytes() const {
+    return (_sx.capacity() + _sy.capacity() + _ex.capacity() + _ey.capacity()) * sizeof(float);
+}
+
+void SegmentBatch::intersect(const Line& line, uint32_t* mask) const {
+    intersectMask(line, _sx.data(), _sy.data(), _ex.data(), _ey.data(), _size, mask);
+}
+
+bool SegmentBatch::intersectsAny(const Line& line) const {
+    // padding lanes can't hit, so run over the whole padded length
+    return intersectAny(line, _sx.data(), _sy.data(), _ex.data(), _ey.data(), _sx.size());
+}
+
+}  // namespace lcycle
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Line.hpp"
+#include "util/AlignedAllocator.hpp"
+
+namespace lcycle {
+
+/*!
+ * Tests line against the n segments whose coordinates are given as separate
+ * arrays, four at a time with simd4f. Bit i % 32 of mask[i / 32] is set iff
+ * segment i intersects line, with the same semantics as Line::intersect.
+ * mask needs room for (n + 31) / 32 words.
+ */
+void intersectMask(const Line& line, const float* sx, const float* sy, const float* ex, const float* ey, size_t n,
+                   uint32_t* mask);
+/*! Like intersectMask, but stops at the first hit. */
+bool intersectAny(const Line& line, const float* sx, const float* sy, const float* ex, const float* ey, size_t n);
+
+/*!
+ * Packed block of segments stored as one aligned array per coordinate, padded
+ * with degenerate segments up to a multiple of 4 so the kernel never needs a
+ * scalar tail.
+ */
+class SegmentBatch {
+   public:
+    SegmentBatch();
+
+    void clear();
+    void reserve(size_t segments);
+    void push(const Line& line);
+    void push(float sx, float sy, float ex, float ey);
+    size_t size() const;
+    /*! Bytes of lane storage allocated, which clear keeps. */
+    size_t heapBytes() const;
+
+    void intersect(const Line& line, uint32_t* mask) const;
+    bool intersectsAny(const Line& line) const;
+
+   private:
+    using Floats = std::vector<float, util::AlignedAllocator<float, 16>>;
+
+    Floats _sx, _sy, _ex, _ey;
+    size_t _size;
+};
+
+}  // namespace lcycle
@@ -0,0 +1,157 @@
+#include "SegmentGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "Line.hpp"
+
+namespace lcycle {
+
+static constexpr uint32_t kNone = ~0u;
+
+SegmentGrid::SegmentGrid(double size, double cellSize)
+    : _heads(),
+      _nodes(),
+      _origin(-size / 2.0),
+      _invCellSize(1.0 / cellSize),
+      _dim(dimFor(size, cellSize)) {
+    _heads.assign((size_t)_dim * _dim, kNone);
+}
+
+int SegmentGrid::dimFor(double size, double cellSize) { return std::max(1, (int)std::ceil(size / cellSize)); }
+
+int SegmentGrid::cellCoord(float v) const {
+    // anything outside the arena is clamped onto the border cells
+    int c = (int)std::floor((v - _origin) * _invCellSize);
+    return std::min(std::max(c, 0), _dim - 1);
+}
+
+SegmentGrid::CellRange SegmentGrid::cellsOf(const Line& line) const {
+    const auto& s = line.start();
+    const auto& e = line.end();
+    return {cellCoord(std::min(s.x(), e.x())), cellCoord(std::min(s.y(), e.y())), cellCoord(std::max(s.x(), e.x())),
+            cellCoord(std::max(s.y(), e.y()))};
+}
+
+void SegmentGrid::push(int x, int y, SegmentRef ref) {
+    const uint32_t cell = y * _dim + x;
+    _nodes.push_back({ref, _heads[cell], cell});
+    _heads.edit(cell) = _nodes.size() - 1;
+}
+
+SegmentGrid::CellRange SegmentGrid::insert(SegmentRef ref, const Line& line) {
+    CellRange r = cellsOf(line);
+    for (int y = r.y0; y <= r.y1; y++) {
+        for (int x = r.x0; x <= r.x1; x++) {
+            push(x, y, ref);
+        }
+    }
+    return r;
+}
+
+SegmentGrid::CellRange SegmentGrid::insert(SegmentRef ref, const Line& line, const CellRange& skip) {
+    CellRange r = cellsOf(line);
+    for (int y = r.y0; y <= r.y1; y++) {
+        for (int x = r.x0; x <= r.x1; x++) {
+            if (x < skip.x0 || x > skip.x1 || y < skip.y0 || y > skip.y1) {
+                push(x, y, ref);
+            }
+        }
+    }
+    return r;
+}
+
+void SegmentGrid::extend(SegmentRef ref, CellRange& covered, const Line& line) {
+    CellRange r = cellsOf(line);
+    CellRange u = {std::min(r.x0, covered.x0), std::min(r.y0, covered.y0), std::max(r.x1, covered.x1),
+                   std::max(r.y1, covered.y1)};
+    if (u.x0 == covered.x0 && u.y0 == covered.y0 && u.x1 == covered.x1 && u.y1 == covered.y1) return;
+
+    // register the union rather than just r, so covered stays a rectangle
+    for (int y = u.y0; y <= u.y1; y++) {
+        for (int x = u.x0; x <= u.x1; x++) {
+            if (x < covered.x0 || x > covered.x1 || y < covered.y0 || y > covered.y1) {
+                push(x, y, ref);
+            }
+        }
+    }
+    covered = u;
+}
+
+void SegmentGrid::reserve(size_t entries) { _nodes.reserve(entries); }
+
+void SegmentGrid::clear() {
+    _heads.assign(_heads.size(), kNone);
+    _nodes.clear();
+}
+
+size_t SegmentGrid::entries() const { return _nodes.size(); }
+
+void SegmentGrid::truncate(size_t entries) {
+    // newest first, so each cell's head ends up at the last node it had left
+    while (_nodes.size() > entries) {
+        _heads.edit(_nodes.back().cell) = _nodes.back().next;
+        _nodes.pop_back();
+    }
+}
+
+size_t SegmentGrid::cells() const { return _heads.size(); }
+
+size_t SegmentGrid::unsharedBytes(const SegmentGrid& other) const {
+    return _heads.unsharedBytes(other._heads) + _nodes.unsharedBytes(other._nodes);
+}
+
+// copies a whole vector a block at a time
+template <typename T, size_t B>
+static void copyOut(const util::CowVector<T, B>& from, T* to) {
+    for (size_t b = 0; b < from.blocks(); b++) {
+        std::memcpy(to + b * B, from.block(b), std::min(B, from.size() - b * B) * sizeof(T));
+    }
+}
+
+template <typename T, size_t B>
+static void copyIn(const T* from, util::CowVector<T, B>& to) {
+    for (size_t b = 0; b < to.blocks(); b++) {
+        std::memcpy(&to.edit(b * B), from + b * B, std::min(B, to.size() - b * B) * sizeof(T));
+    }
+}
+
+void SegmentGrid::save(uint32_t* heads, Node* nodes) const {
+    copyOut(_heads, heads);
+    copyOut(_nodes, nodes);
+}
+
+void SegmentGrid::load(const uint32_t* heads, const Node* nodes, size_t entries) {
+    _nodes.resize(entries);
+    copyIn(heads, _heads);
+    copyIn(nodes, _nodes);
+}
+
+void SegmentGrid::query(const Line& line, std::vector<SegmentRef>& out) const { query(cellsOf(line), out); }
+
+void SegmentGrid::query(const mathfu::vec2& lo, const mathfu::vec2& hi, std::vector<SegmentRef>& out) const {
+    query({cellCoord(lo.x()), cellCoord(lo.y()), cellCoord(hi.x()), cellCoord(hi.y())}, out);
+}
+
+void SegmentGrid::query(const CellRange& r, std::vector<SegmentRef>& out) const {
+    const size_t first = out.size();
+    for (int y = r.y0; y <= r.y1; y++) {
+        for (int x = r.x0; x <= r.x1; x++) {
+            for (uint32_t n = _heads[y * _dim + x]; n != kNone; n = _nodes[n].next) {
+                out.push_back(_nodes[n].ref);
+            }
+        }
+    }
+
+    // segments spanning several cells show up once per cell
+    if (r.x0 != r.x1 || r.y0 != r.y1) {
+        auto less = [](SegmentRef a, SegmentRef b) { return a.trail != b.trail ? a.trail < b.trail : a.seg < b.seg; };
+        auto eq = [](SegmentRef a, SegmentRef b) { return a.trail == b.trail && a.seg == b.seg; };
+        std::sort(out.begin() + first, out.end(), less);
+        out.erase(std::unique(out.begin() + first, out.end(), eq), out.end());
+    }
+}
+
+}  // namespace lcycle
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <mathfu/glsl_mappings.h>
+
+#include "Line.hpp"
+#include "util/CowVector.hpp"
+
+namespace lcycle {
+
+struct SegmentRef {
+    /*! Set in seg when it indexes the trail's runs rather than its segments. */
+    static constexpr uint32_t RUN = 1u << 31;
+
+    uint32_t trail;
+    uint32_t seg;
+};
+
+/*!
+ * Uniform grid over the arena, bucketing trail segments by the cells their
+ * bounding box overlaps. Buckets are intrusive lists in one flat node pool so
+ * that copying a grid is two vector copies, which share their storage until
+ * either side writes to it.
+ */
+class SegmentGrid {
+   public:
+    struct CellRange {
+        int x0, y0, x1, y1;
+    };
+    /*! One (segment, cell) pair, linked to the pair registered in the same cell before it. */
+    struct Node {
+        SegmentRef ref;
+        uint32_t next;
+        uint32_t cell;
+    };
+
+    SegmentGrid(double size = 0.0, double cellSize = 2.0);
+
+    /*! How many cells across a grid over an arena of size size is. */
+    static int dimFor(double size, double cellSize = 2.0);
+
+    /*! Registers line under ref and returns the cells it was put in. */
+    CellRange insert(SegmentRef ref, const Line& line);
+    /*!
+     * Registers line under ref in the cells it overlaps outside skip. Walking
+     * the pieces of a straight line with skip set to the previous piece's
+     * cells puts ref in every cell the pieces touch exactly once.
+     */
+    CellRange insert(SegmentRef ref, const Line& line, const CellRange& skip);
+    /*! Registers ref in any cells line overlaps that covered doesn't, then grows covered to match. */
+    void extend(SegmentRef ref, CellRange& covered, const Line& line);
+    /*! Preallocates room for this many (segment, cell) pairs. */
+    void reserve(size_t entries);
+    /*! Forgets every segment, keeping the allocated storage. */
+    void clear();
+    /*! How many (segment, cell) pairs have been registered. */
+    size_t entries() const;
+    /*! Forgets everything registered after the grid held this many entries. */
+    void truncate(size_t entries);
+    /*! Appends every ref sharing a cell with line to out, without duplicates. */
+    void query(const Line& line, std::vector<SegmentRef>& out) const;
+    /*! Same as above for the axis aligned box spanned by lo and hi. */
+    void query(const mathfu::vec2& lo, const mathfu::vec2& hi, std::vector<SegmentRef>& out) const;
+
+    /*! How many cells the grid has. */
+    size_t cells() const;
+    /*! Heap bytes of node and head blocks this grid holds that other doesn't share. */
+    size_t unsharedBytes(const SegmentGrid& other) const;
+    /*! Copies the head of every cell's list to heads and every entry to nodes. */
+    void save(uint32_t* heads, Node* nodes) const;
+    /*! Replaces the contents with what save wrote, for a grid of the same size. */
+    void load(const uint32_t* heads, const Node* nodes, size_t entries);
+
+   private:
+    CellRange cellsOf(const Line& line) const;
+    void query(const CellRange& r, std::vector<SegmentRef>& out) const;
+    int cellCoord(float v) const;
+    void push(int x, int y, SegmentRef ref);
+
+    // copy on write, so copying a grid shares everything registered so far
+    util::CowVector<uint32_t, 256> _heads;
+    util::CowVector<Node, 256> _nodes;
+    float _origin;
+    float _invCellSize;
+    int _dim;
+};
+
+}  // namespace lcycle
@@ -1,39 +1,183 @@
 #include "Trail.hpp"
 #include <mathfu/glsl_mappings.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <utility>
 #include <vector>
 #include "Line.hpp"
 
 namespace lcycle {
 
-Trail::Trail(const mathfu::vec4& color) : _trail(), _color(color) {}
-Trail::Trail(const Trail& other) : _trail(other._trail), _color(other._color) {}
-Trail::Trail(Trail&& other) : _trail(std::move(other._trail)), _color(std::move(other._color)) {}
+// fewest segments worth folding into a run
+static const size_t MIN_RUN = 3;
 
-Trail& Trail::operator=(const Trail& other) {
-    _trail = other._trail;
-    _color = other._color;
-    return *this;
+Line DashedRun::dash(uint32_t k) const {
+    mathfu::vec2 s = start + (float)((double)k * period) * dir;
+    return Line(s, s + length * dir);
 }
 
-Trail& Trail::operator=(Trail&& other) {
-    _trail = std::move(other._trail);
-    _color = std::move(other._color);
-    return *this;
+Line DashedRun::span() const { return Line(dash(0).start(), dash(count - 1).end()); }
+
+std::pair<uint32_t, uint32_t> DashedRun::dashesNear(const mathfu::vec2& lo, const mathfu::vec2& hi) const {
+    // project the corners of the box onto the run and keep the dashes
+    // overlapping that interval
+    double tMin = INFINITY, tMax = -INFINITY;
+    for (const auto& c : {lo, hi, mathfu::vec2(lo.x(), hi.y()), mathfu::vec2(hi.x(), lo.y())}) {
+        double t = mathfu::vec2::DotProduct(c - start, dir);
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    double first = std::max(0.0, std::floor((tMin - length) / period));
+    double last = std::min((double)count, std::floor(tMax / period) + 1.0);
+    if (last <= first) return {0, 0};
+    return {(uint32_t)first, (uint32_t)last};
+}
+
+Trail::Trail(const mathfu::vec4& color) : _sx(), _sy(), _ex(), _ey(), _runs(), _color(color) {}
+
+size_t Trail::size() const { return _sx.size(); }
+
+Line Trail::operator[](size_t idx) const {
+    return Line(mathfu::vec2(_sx[idx], _sy[idx]), mathfu::vec2(_ex[idx], _ey[idx]));
 }
 
-size_t Trail::size() const { return _trail.size(); }
+size_t Trail::blocks() const { return _sx.blocks(); }
+
+const float* Trail::sx(size_t block) const { return _sx.block(block); }
 
-Line& Trail::operator[](size_t idx) { return _trail[idx]; }
+const float* Trail::sy(size_t block) const { return _sy.block(block); }
 
-const Line& Trail::operator[](size_t idx) const { return _trail[idx]; }
+const float* Trail::ex(size_t block) const { return _ex.block(block); }
 
-const std::vector<Line>& Trail::data() const { return _trail; }
+const float* Trail::ey(size_t block) const { return _ey.block(block); }
 
 const mathfu::vec4& Trail::color() const { return _color; }
 
 mathfu::vec4& Trail::color() { return _color; }
 
-void Trail::add(const Line& line) { _trail.push_back(line); }
+void Trail::add(const Line& line) {
+    _sx.push_back(line.start().x());
+    _sy.push_back(line.start().y());
+    _ex.push_back(line.end().x());
+    _ey.push_back(line.end().y());
+}
+
+void Trail::reserve(size_t segments) {
+    _sx.reserve(segments);
+    _sy.reserve(segments);
+    _ex.reserve(segments);
+    _ey.reserve(segments);
+}
+
+void Trail::extendTo(const mathfu::vec2& end) {
+    _ex.editBack() = end.x();
+    _ey.editBack() = end.y();
+}
+
+void Trail::truncate(size_t n, const Line& last) {
+    _sx.resize(n);
+    _sy.resize(n);
+    _ex.resize(n);
+    _ey.resize(n);
+    if (n == 0) return;
+    _sx.editBack() = last.start().x();
+    _sy.editBack() = last.start().y();
+    _ex.editBack() = last.end().x();
+    _ey.editBack() = last.end().y();
+}
+
+void Trail::clear() {
+    _sx.clear();
+    _sy.clear();
+    _ex.clear();
+    _ey.clear();
+    _runs.reset();
+}
+
+size_t Trail::unsharedBytes(const Trail& other) const {
+    size_t bytes = _sx.unsharedBytes(other._sx) + _sy.unsharedBytes(other._sy) + _ex.unsharedBytes(other._ex) +
+                   _ey.unsharedBytes(other._ey);
+    if (_runs && _runs != other._runs) bytes += _runs->capacity() * sizeof(DashedRun);
+    return bytes;
+}
+
+void Trail::setRuns(std::vector<DashedRun> runs) {
+    _runs = runs.empty() ? nullptr : std::make_shared<std::vector<DashedRun>>(std::move(runs));
+}
+
+const std::vector<DashedRun>& Trail::runs() const {
+    static const std::vector<DashedRun> none;
+    return _runs ? *_runs : none;
+}
+
+bool Trail::fits(const DashedRun& run, uint32_t k, size_t idx, float tolerance) const {
+    Line d = run.dash(k);
+    Line l = (*this)[idx];
+    return (d.start() - l.start()).LengthSquared() <= tolerance * tolerance &&
+           (d.end() - l.end()).LengthSquared() <= tolerance * tolerance;
+}
+
+size_t Trail::compact(float tolerance) {
+    using namespace mathfu;
+
+    if (size() < 2) return 0;
+    const size_t n = size() - 1;
+
+    // copies sharing the runs keep their own
+    _runs = _runs ? std::make_shared<std::vector<DashedRun>>(*_runs) : std::make_shared<std::vector<DashedRun>>();
+    auto& runs = *_runs;
+
+    size_t kept = 0;
+    auto keep = [&](size_t i) {
+        // leave blocks shared with copies alone where nothing moves
+        if (kept != i) {
+            _sx.edit(kept) = _sx[i];
+            _sy.edit(kept) = _sy[i];
+            _ex.edit(kept) = _ex[i];
+            _ey.edit(kept) = _ey[i];
+        }
+        kept++;
+    };
+
+    for (size_t i = 0; i < n;) {
+        // carry on the newest run, possibly from an earlier compaction
+        if (!runs.empty() && fits(runs.back(), runs.back().count, i, tolerance)) {
+            runs.back().count++;
+            i++;
+            continue;
+        }
+
+        // otherwise guess a run from the first two segments and check the third agrees
+        if (i + MIN_RUN <= n) {
+            Line first = (*this)[i];
+            Line second = (*this)[i + 1];
+            double length = first.len();
+            double period = (second.start() - first.start()).Length();
+            if (length > tolerance && period > length) {
+                DashedRun run = {first.start(), (first.end() - first.start()) / (float)length, (float)length,
+                                 (float)period, 0};
+                bool ok = true;
+                for (uint32_t k = 0; k < MIN_RUN && ok; k++) ok = fits(run, k, i + k, tolerance);
+                if (ok) {
+                    run.count = MIN_RUN;
+                    runs.push_back(run);
+                    i += MIN_RUN;
+                    continue;
+                }
+            }
+        }
+
+        keep(i++);
+    }
+    keep(n);
+
+    const size_t removed = size() - kept;
+    _sx.resize(kept);
+    _sy.resize(kept);
+    _ex.resize(kept);
+    _ey.resize(kept);
+    return removed;
+}
 
 }  // namespace lcycle
@@ -2,31 +2,90 @@
 
 #include <mathfu/constants.h>
 #include <mathfu/glsl_mappings.h>
+#include <cstdint>
+#include <memory>
+#include <utility>
 #include <vector>
 #include "Line.hpp"
+#include "util/CowVector.hpp"
 
 namespace lcycle {
 
+/*!
+ * count evenly spaced, equally long dashes along one straight line, which is
+ * what a cycle driving straight leaves behind. Dash k runs from
+ * start + k * period * dir to length further along the unit vector dir.
+ */
+struct DashedRun {
+    mathfu::vec2 start;
+    mathfu::vec2 dir;
+    float length;
+    float period;
+    uint32_t count;
+
+    Line dash(uint32_t k) const;
+    /*! From the start of the first dash to the end of the last. */
+    Line span() const;
+    /*! First and one past the last dash that may overlap the box spanned by lo and hi. */
+    std::pair<uint32_t, uint32_t> dashesNear(const mathfu::vec2& lo, const mathfu::vec2& hi) const;
+};
+
+/*!
+ * Segments are stored as one 16 byte aligned array per coordinate (start x/y,
+ * end x/y), split into copy on write blocks of BLOCK segments. Collision
+ * kernels and the renderer can stream through a block at a time, and copying
+ * a trail shares all of its blocks.
+ */
 class Trail {
    public:
+    static constexpr size_t BLOCK = 64;
+
     Trail(const mathfu::vec4& color = mathfu::kOnes4f);
-    Trail(const Trail& other);
-    Trail& operator=(const Trail& other);
-    Trail(Trail&& other);
-    Trail& operator=(Trail&& other);
 
     size_t size() const;
-    Line& operator[](size_t idx);
-    const Line& operator[](size_t idx) const;
-    const std::vector<Line>& data() const;
+    Line operator[](size_t idx) const;
+
+    /*! Block b holds segments [b * BLOCK, min(size(), (b + 1) * BLOCK)). */
+    size_t blocks() const;
+    const float* sx(size_t block) const;
+    const float* sy(size_t block) const;
+    const float* ex(size_t block) const;
+    const float* ey(size_t block) const;
 
     const mathfu::vec4& color() const;
     mathfu::vec4& color();
 
     void add(const Line& line);
+    void reserve(size_t segments);
+    /*! Moves the end of the last segment to end. */
+    void extendTo(const mathfu::vec2& end);
+    /*! Drops every segment past the first n, then makes the last one left last. */
+    void truncate(size_t n, const Line& last);
+
+    /*! Forgets every segment and run. */
+    void clear();
+
+    /*! Heap bytes of segment blocks and runs this trail holds that other doesn't share. */
+    size_t unsharedBytes(const Trail& other) const;
+
+    const std::vector<DashedRun>& runs() const;
+    void setRuns(std::vector<DashedRun> runs);
+    /*!
+     * Folds runs of at least three collinear, evenly spaced segments into
+     * DashedRuns, moving no endpoint by more than tolerance. The last segment
+     * is left alone since it may still be growing, the order of the others is
+     * kept. Returns how many segments were removed.
+     */
+    size_t compact(float tolerance);
 
    private:
-    std::vector<Line> _trail;
+    using Floats = util::CowVector<float, BLOCK>;
+
+    bool fits(const DashedRun& run, uint32_t k, size_t idx, float tolerance) const;
+
+    Floats _sx, _sy, _ex, _ey;
+    // shared between copies too, only compact() changes it and it clones first
+    std::shared_ptr<std::vector<DashedRun>> _runs;
     mathfu::vec4 _color;
 };
 
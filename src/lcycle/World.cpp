@@ -1,120 +1,764 @@
 #include "World.hpp"
 
 #include <algorithm>
-#include <map>
-#include <set>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
 #include <mathfu/glsl_mappings.h>
 
 #include "Cycle.hpp"
+#include "SegmentBatch.hpp"
+#include "SegmentGrid.hpp"
 
 namespace lcycle {
 
-World::World() : _players(), _trails(), _size(0.0), _dashTime(0.0), _curTime(0.0), _drawing(false) {}
+// most a cycle may turn along one straight piece of its swept path, in degrees
+static const double MAX_SWEEP_TURN = 10.0;
+// nearby segments a single cycle is expected to be tested against at most
+static const size_t SCRATCH_SEGMENTS = 1024;
+// furthest a clearance certificate looks for obstacles
+static const double MAX_CLEARANCE = 4.0;
 
-World::World(double size, double dashTime, const std::vector<Player>& players)
-    : _players(players), _trails(_players.size()), _size(size), _dashTime(dashTime), _curTime(0.0), _drawing(false) {
+// folds v into the state hash h, mixing well enough that nearby values and
+// swapped ones land far apart
+static uint64_t fold(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ull;
+    h *= 0xbf58476d1ce4e5b9ull;
+    return h ^ (h >> 31);
+}
+
+static uint64_t bits(float x, float y) {
+    uint32_t bx, by;
+    std::memcpy(&bx, &x, sizeof(bx));
+    std::memcpy(&by, &y, sizeof(by));
+    return (uint64_t)by << 32 | bx;
+}
+
+static uint64_t bits(double d) {
+    uint64_t b;
+    std::memcpy(&b, &d, sizeof(b));
+    return b;
+}
+
+template <size_t N>
+BasicWorld<N>::BasicWorld()
+    : _roster(std::make_shared<const Roster>()),
+      _players(),
+      _idToIdx(),
+      _trailIdx(),
+      _trails(),
+      _lastCells(),
+      _grid(),
+      _size(0.0),
+      _dashTime(0.0),
+      _kinematics(Kinematics::Float),
+      _curTime(0.0),
+      _drawing(false),
+      _clearance(),
+      _sweepOrder(),
+      _stats(),
+      _hash(0),
+      _scratch() {}
+
+template <size_t N>
+BasicWorld<N>::BasicWorld(double size, double dashTime, const std::vector<Player>& players, Kinematics kinematics)
+    : _roster(std::make_shared<const Roster>(players)),
+      _players(),
+      _idToIdx(),
+      _trailIdx(players.size()),
+      _trails(players.size()),
+      _lastCells(players.size()),
+      _grid(size),
+      _size(size),
+      _dashTime(dashTime),
+      _kinematics(kinematics),
+      _curTime(0.0),
+      _drawing(false),
+      _clearance(players.size(), {0.0f, 0.0f}),
+      _sweepOrder(players.size()),
+      _stats(),
+      _hash(0),
+      _scratch() {
     for (size_t i = 0; i < _trails.size(); i++) {
-        _trails[i].color() = _players[i].tColor;
+        const Player& player = (*_roster)[i];
+        _players.push_back({player.cycle, player.id});
+        // start from exactly where fixed point steering will take over
+        if (kinematics == Kinematics::Fixed) _players.back().cycle.snapToFixed();
+        if constexpr (N == 0) {
+            if ((size_t)player.id >= _idToIdx.size()) _idToIdx.resize(player.id + 1, -1);
+            _idToIdx[player.id] = i;
+        }
+        _trailIdx[i] = i;
+        _sweepOrder[i] = i;
+        _trails[i].color() = player.tColor;
     }
+    _hash = fold(fold(fold(0, bits(size)), bits(dashTime)), (uint64_t)kinematics);
+    hashCycles();
 }
 
-void World::runFor(double secs, const std::vector<std::pair<int, CycleInput>>& inputs) {
+template <size_t N>
+void BasicWorld<N>::reserve(size_t segmentsPerTrail) {
+    for (auto& trail : _trails) trail.reserve(segmentsPerTrail);
+    // most segments fit in a cell or two, a few straddle a corner
+    _grid.reserve(2 * segmentsPerTrail * _trails.size());
+
+    const size_t nPlayers = _players.size();
+    auto& s = _scratch;
+    s.inputs.reserve(nPlayers);
+    s.prevCycles.reserve(nPlayers);
+    s.prevLines.reserve(nPlayers);
+    s.cycLines.reserve(nPlayers);
+    s.turns.reserve(nPlayers);
+    s.steps.reserve(nPlayers);
+    s.moving.reserve(nPlayers);
+    s.movingTurns.reserve(nPlayers);
+    s.skip.reserve((nPlayers + 63) / 64);
+    s.liveTrail.reserve(_trails.size());
+    // a frame of 1/60s turns less than MAX_SWEEP_TURN, leave room for much coarser ones
+    s.sweep.reserve(nPlayers * 16);
+    s.sweepStart.reserve(nPlayers + 1);
+    s.kill.reserve((nPlayers + 63) / 64);
+    s.boxLo.reserve(nPlayers);
+    s.boxHi.reserve(nPlayers);
+    // cycles rarely crowd each other, a handful of neighbours each is plenty
+    s.nearPairs.reserve(nPlayers * 8);
+    s.nearCycle.reserve(nPlayers);
+    s.nearby.reserve(SCRATCH_SEGMENTS);
+    s.batch.reserve(SCRATCH_SEGMENTS);
+}
+
+template <size_t N>
+void BasicWorld<N>::runFor(double secs, const PlayerInputs& inputs) {
     using namespace mathfu;
 
-    std::map<int, int> livingPlayers;
-    for (auto i = 0u; i < _players.size(); i++) {
-        livingPlayers.insert({_players[i].id, i});
-    }
-    std::vector<std::pair<int, CycleInput>> adjustedInputs;
+    const size_t nPlayers = _players.size();
+    auto& s = _scratch;
+
+    s.inputs.clear();
     for (const auto& input : inputs) {
-        if (livingPlayers.count(input.first) > 0) {
-            adjustedInputs.push_back({livingPlayers[input.first], input.second});
+        int idx = indexOf(input.first);
+        if (idx >= 0) {
+            CycleInput clamped = {std::max(-1.0f, std::min(1.0f, input.second.turnDir))};
+            s.inputs.push_back({idx, clamped});
         }
     }
 
+    // where each cycle was before moving and how far it turned, for swept collisions
+    s.prevCycles.clear();
+    s.prevLines.clear();
+    s.turns.assign(nPlayers, 0.0);
+    s.steps.assign(nPlayers, 0.0);
+    for (auto& player : _players) {
+        s.prevCycles.push_back(player.cycle);
+        s.prevLines.push_back(player.cycle.toLine());
+    }
+
     // update cycle positions
-    for (const auto& input : adjustedInputs) {
-        auto& player = _players[input.first];
-        player.cycle.rotate(-1 * TURN_SPEED * secs * input.second.turnDir);
-        player.cycle.runFor(secs);
+    for (const auto& input : s.inputs) {
+        s.turns[input.first] = -1 * TURN_SPEED * secs * input.second.turnDir;
+        // furthest any point of the cycle can have moved
+        s.steps[input.first] =
+            CYCLE_SPEED * secs + std::fabs(s.turns[input.first]) * M_PI / 180.0 * CYCLE_LENGTH / 2.0;
     }
+    updateCycles(secs);
 
-    _curTime += secs;
-    if (_drawing && _curTime >= 2 * _dashTime) {
-        _drawing = false;
-    } else if (_drawing) {
-        for (const auto& input : adjustedInputs) {
-            auto i = input.first;
-            auto coord = _players[i].cycle.toLine().start();
-            _trails[i][_trails[i].size() - 1].end() = coord;
+    // cycles whose clearance outlasts this frame's movement can't have hit
+    // anything, so all of their checks are skipped. Other cycles move at most
+    // maxStep, which bounds how fast dynamic obstacles closed in.
+    auto isSet = [](const Mask& mask, size_t i) { return (mask[i / 64] >> (i % 64)) & 1; };
+    double maxStep = 0.0;
+    for (auto step : s.steps) maxStep = std::max(maxStep, step);
+    s.skip.assign((nPlayers + 63) / 64, 0);
+    for (size_t i = 0; i < nPlayers; i++) {
+        auto& c = _clearance[i];
+        if (c.stat > s.steps[i] && c.dyn > s.steps[i] + maxStep) {
+            c.stat -= s.steps[i];
+            c.dyn -= s.steps[i] + maxStep;
+            s.skip[i / 64] |= uint64_t(1) << (i % 64);
+            _stats.skipped++;
+        } else {
+            _stats.checked++;
         }
-    } else if (_curTime > _dashTime) {
-        for (const auto& input : adjustedInputs) {
-            auto i = input.first;
-            auto coord = _players[i].cycle.toLine().start();
-            _trails[i].add(Line(coord, coord));
+    }
+
+    s.cycLines.clear();
+    for (auto& player : _players) {
+        s.cycLines.push_back(player.cycle.toLine());
+    };
+
+    // walk the dash schedule through the frame, so segments start and stop at
+    // the same place however coarse the timestep is. The back of each cycle is
+    // taken to move in a straight line over the frame.
+    auto backAt = [&](size_t i, double when) {
+        vec2 from = s.prevLines[i].start();
+        vec2 to = s.cycLines[i].start();
+        return when < secs ? from + (float)(when / secs) * (to - from) : to;
+    };
+    auto extendTrails = [&](double when) {
+        for (const auto& input : s.inputs) {
+            auto t = _trailIdx[input.first];
+            auto last = (uint32_t)_trails[t].size() - 1;
+            _trails[t].extendTo(backAt(input.first, when));
+            _grid.extend({t, last}, _lastCells[t], _trails[t][last]);
+        }
+    };
+    if (_dashTime > 0.0) {
+        double elapsed = 0.0;
+        while (true) {
+            double flip = (_drawing ? 2 * _dashTime : _dashTime) - _curTime;
+            if (flip > secs - elapsed) break;
+            elapsed += std::max(flip, 0.0);
+            if (_drawing) {
+                extendTrails(elapsed);
+                _drawing = false;
+                _curTime = 0.0;
+            } else {
+                for (const auto& input : s.inputs) {
+                    auto t = _trailIdx[input.first];
+                    auto coord = backAt(input.first, elapsed);
+                    _trails[t].add(Line(coord, coord));
+                    _lastCells[t] = _grid.insert({t, (uint32_t)_trails[t].size() - 1}, Line(coord, coord));
+                }
+                _drawing = true;
+                _curTime = _dashTime;
+            }
+        }
+        _curTime += secs - elapsed;
+        if (_drawing) extendTrails(secs);
+
+        // whatever was added or extended this frame is in the last segment of
+        // the trails of cycles that moved
+        for (const auto& input : s.inputs) {
+            const auto t = _trailIdx[input.first];
+            const size_t n = _trails[t].size();
+            _hash = fold(_hash, (uint64_t)t << 32 | n);
+            if (n == 0) continue;
+            const Line last = _trails[t][n - 1];
+            _hash = fold(_hash, bits(last.start().x(), last.start().y()));
+            _hash = fold(_hash, bits(last.end().x(), last.end().y()));
         }
-        _drawing = true;
     }
-    _curTime = fmod(_curTime, 2 * _dashTime);
 
     // players that died this frame, RIP
-    std::set<size_t> kill;
+    s.kill.assign((nPlayers + 63) / 64, 0);
+    auto kill = [&](size_t i) { s.kill[i / 64] |= uint64_t(1) << (i % 64); };
 
-    std::vector<Line> cycLines;
-    cycLines.reserve(_players.size());
-    for (auto& player : _players) {
-        cycLines.push_back(player.cycle.toLine());
+    // path the front of each cycle swept this frame, as a polyline with a
+    // vertex every MAX_SWEEP_TURN degrees. Together with the new cycle line it
+    // bounds everything the cycle ran over, so large timesteps can't tunnel
+    // through trails. The back only covers ground the front already did, and
+    // the old line was checked on the previous frame.
+    s.sweep.clear();
+    s.sweepStart.clear();
+    for (size_t i = 0; i < nPlayers; i++) {
+        s.sweepStart.push_back(s.sweep.size());
+        s.sweep.push_back(s.prevLines[i].end());
+        int pieces = std::max(1, (int)std::ceil(std::fabs(s.turns[i]) / MAX_SWEEP_TURN));
+        Cycle c = s.prevCycles[i];
+        for (int k = 1; k < pieces; k++) {
+            steer(c, secs / pieces, s.turns[i] / pieces);
+            s.sweep.push_back(c.toLine().end());
+        }
+        s.sweep.push_back(s.cycLines[i].end());
+    }
+    s.sweepStart.push_back(s.sweep.size());
+    // whether line crosses the path the front of cycle i swept
+    auto sweptAcross = [&](size_t i, const Line& line) {
+        for (size_t k = s.sweepStart[i] + 1; k < s.sweepStart[i + 1]; k++) {
+            if (Line::intersect(Line(s.sweep[k - 1], s.sweep[k]), line)) return true;
+        }
+        return false;
     };
 
     // check for collisions against the edges
     float sizeDiv2 = _size / 2;
-    for (size_t i = 0; i < cycLines.size(); i++) {
-        auto& line = cycLines[i];
+    for (size_t i = 0; i < nPlayers; i++) {
+        if (isSet(s.skip, i)) continue;
+        auto& line = s.cycLines[i];
         if (!InRange2D(line.start(), vec2(-sizeDiv2, -sizeDiv2), vec2(sizeDiv2, sizeDiv2)) ||
             !InRange2D(line.end(), vec2(-sizeDiv2, -sizeDiv2), vec2(sizeDiv2, sizeDiv2))) {
-            kill.insert(i);
+            kill(i);
         }
     }
 
-    // check for cycle-cycle collisions
-    for (size_t i = 0; i < cycLines.size(); i++) {
-        auto& first = cycLines[i];
-        for (size_t j = i + 1; j < cycLines.size(); j++) {
-            auto& second = cycLines[j];
-            if (Line::intersect(first, second)) {
-                kill.insert({i, j});
+    // bounding box of everything each cycle covered this frame
+    s.boxLo.clear();
+    s.boxHi.clear();
+    for (size_t i = 0; i < nPlayers; i++) {
+        const auto& l = s.cycLines[i];
+        vec2 lo = vec2::Min(l.start(), l.end());
+        vec2 hi = vec2::Max(l.start(), l.end());
+        for (size_t k = s.sweepStart[i]; k < s.sweepStart[i + 1]; k++) {
+            lo = vec2::Min(lo, s.sweep[k]);
+            hi = vec2::Max(hi, s.sweep[k]);
+        }
+        s.boxLo.push_back(lo);
+        s.boxHi.push_back(hi);
+    }
+
+    // check for cycle-cycle collisions with sort and sweep on the x axis.
+    // Cycles barely move between frames, so insertion sort on last frame's
+    // order runs in close to linear time. Pairs within MAX_CLEARANCE of each
+    // other are remembered for the clearance certificates.
+    auto& order = _sweepOrder;
+    for (size_t a = 1; a < nPlayers; a++) {
+        uint32_t i = order[a];
+        size_t b = a;
+        for (; b > 0 && s.boxLo[order[b - 1]].x() > s.boxLo[i].x(); b--) order[b] = order[b - 1];
+        order[b] = i;
+    }
+    s.nearPairs.clear();
+    for (size_t a = 0; a < nPlayers; a++) {
+        const uint32_t i = order[a];
+        const vec2& lo = s.boxLo[i];
+        const vec2& hi = s.boxHi[i];
+        for (size_t b = a + 1; b < nPlayers; b++) {
+            const uint32_t j = order[b];
+            if (s.boxLo[j].x() > hi.x() + MAX_CLEARANCE) break;
+            if (isSet(s.skip, i) && isSet(s.skip, j)) continue;
+            if (s.boxLo[j].y() > hi.y() + MAX_CLEARANCE || lo.y() > s.boxHi[j].y() + MAX_CLEARANCE) continue;
+            s.nearPairs.push_back({std::min(i, j), std::max(i, j)});
+
+            if (isSet(s.skip, i) || isSet(s.skip, j)) continue;
+            if (s.boxLo[j].x() > hi.x() || s.boxLo[j].y() > hi.y() || lo.y() > s.boxHi[j].y()) continue;
+            // either front running into the other cycle, or the fronts'
+            // paths crossing, which they can without either ending up on the
+            // other when frames are long
+            auto p = s.nearPairs.back();
+            bool hit = Line::intersect(s.cycLines[p.first], s.cycLines[p.second]) ||
+                       sweptAcross(p.first, s.cycLines[p.second]) || sweptAcross(p.second, s.cycLines[p.first]);
+            for (size_t k = s.sweepStart[p.second] + 1; k < s.sweepStart[p.second + 1] && !hit; k++) {
+                hit = sweptAcross(p.first, Line(s.sweep[k - 1], s.sweep[k]));
+            }
+            if (hit) {
+                kill(i);
+                kill(j);
             }
         }
     }
 
-    // check for cycle-trail collisions
-    for (auto& trail : _trails) {
-        for (auto& line : trail.data()) {
-            for (size_t i = 0; i < cycLines.size(); i++) {
-                if (Line::intersect(cycLines[i], line)) {
-                    kill.insert(i);
-                }
+    // check for cycle-trail collisions, only against segments sharing a grid cell
+    for (size_t i = 0; i < nPlayers; i++) {
+        if (isSet(s.skip, i)) continue;
+        s.nearby.clear();
+        s.batch.clear();
+        const auto& l = s.cycLines[i];
+        _grid.query(s.boxLo[i], s.boxHi[i], s.nearby);
+        for (const auto& ref : s.nearby) {
+            const auto& trail = _trails[ref.trail];
+            if (ref.seg & SegmentRef::RUN) {
+                const auto& run = trail.runs()[ref.seg & ~SegmentRef::RUN];
+                auto near = run.dashesNear(s.boxLo[i], s.boxHi[i]);
+                for (uint32_t k = near.first; k < near.second; k++) s.batch.push(run.dash(k));
+                continue;
+            }
+            // the segment this cycle is still drawing ends at its back, so it
+            // can't be hit. A chord of the front's path can cross it when a
+            // single frame turns further than the angle between the ends.
+            if (_drawing && ref.trail == _trailIdx[i] && ref.seg == trail.size() - 1) continue;
+            s.batch.push(trail[ref.seg]);
+        }
+        bool hit = s.batch.intersectsAny(l);
+        for (size_t k = s.sweepStart[i] + 1; k < s.sweepStart[i + 1] && !hit; k++) {
+            hit = s.batch.intersectsAny(Line(s.sweep[k - 1], s.sweep[k]));
+        }
+        if (hit) {
+            kill(i);
+        }
+    }
+
+    // give every surviving cycle that was checked a fresh certificate
+    s.liveTrail.assign(_trails.size(), 0);
+    for (auto t : _trailIdx) s.liveTrail[t] = _drawing;
+    auto needsClearance = [&](size_t i) { return !isSet(s.skip, i) && !isSet(s.kill, i); };
+    s.nearCycle.assign(nPlayers, MAX_CLEARANCE);
+    for (const auto& p : s.nearPairs) {
+        if (!needsClearance(p.first) && !needsClearance(p.second)) continue;
+        float d = Line::distance(s.cycLines[p.first], s.cycLines[p.second]);
+        s.nearCycle[p.first] = std::min(s.nearCycle[p.first], d);
+        s.nearCycle[p.second] = std::min(s.nearCycle[p.second], d);
+    }
+    for (size_t i = 0; i < nPlayers; i++) {
+        if (needsClearance(i)) updateClearance(i);
+    }
+
+    // remove dead players, highest index first so the swaps don't disturb the rest
+    for (size_t w = s.kill.size(); w-- > 0;) {
+        for (int b = 63; b >= 0; b--) {
+            if (!(s.kill[w] >> b & 1)) continue;
+            size_t i = w * 64 + b;
+            size_t last = _players.size() - 1;
+            if constexpr (N == 0) {
+                _idToIdx[_players[last].id] = i;
+                _idToIdx[_players[i].id] = -1;
             }
+            std::swap(_players[i], _players[last]);
+            std::swap(_trailIdx[i], _trailIdx[last]);
+            std::swap(_clearance[i], _clearance[last]);
+            _sweepOrder.erase(std::find(_sweepOrder.begin(), _sweepOrder.end(), i));
+            if (i != last) *std::find(_sweepOrder.begin(), _sweepOrder.end(), last) = i;
+            _players.pop_back();
+            _trailIdx.pop_back();
+            _clearance.pop_back();
+            // notice that trails aren't removed
         }
     }
 
-    // remove dead players
-    for (auto i = kill.rbegin(); i != kill.rend(); ++i) {
-        std::swap(_players[*i], _players[_players.size() - 1]);
-        std::swap(_trails[*i], _trails[_trails.size() - 1]);
-        _players.pop_back();
-        // notice that trails aren't removed
+    hashCycles();
+}
+
+template <size_t N>
+void BasicWorld<N>::hashCycles() {
+    _hash = fold(_hash, bits(_curTime) ^ _drawing);
+    for (const auto& player : _players) {
+        const auto& c = player.cycle;
+        _hash = fold(_hash, (uint64_t)(uint32_t)player.id);
+        _hash = fold(_hash, bits(c.pos().x(), c.pos().y()));
+        _hash = fold(_hash, bits(c.heading().x(), c.heading().y()));
+    }
+}
+
+template <size_t N>
+void BasicWorld<N>::updateCycles(double secs) {
+    auto& s = _scratch;
+    s.moving.clear();
+    s.movingTurns.clear();
+    for (const auto& input : s.inputs) {
+        s.moving.push_back(&_players[input.first].cycle);
+        s.movingTurns.push_back(s.turns[input.first]);
+    }
+    if (_kinematics == Kinematics::Fixed) {
+        for (size_t k = 0; k < s.moving.size(); k++) steer(*s.moving[k], secs, s.movingTurns[k]);
+    } else {
+        Cycle::steerAll(secs, s.moving.data(), s.movingTurns.data(), s.moving.size());
+    }
+}
+
+template <size_t N>
+void BasicWorld<N>::steer(Cycle& c, double secs, double turn) const {
+    if (_kinematics == Kinematics::Fixed) {
+        c.steerFixed(toFixed(CYCLE_SPEED * secs), turnFromDegrees(turn));
+    } else {
+        c.steer(secs, turn);
+    }
+}
+
+template <size_t N>
+size_t BasicWorld<N>::compact(float tolerance) {
+    size_t removed = 0;
+    for (auto& trail : _trails) removed += trail.compact(tolerance);
+    if (removed == 0) return 0;
+
+    // segment indices moved, so every trail has to be registered again
+    _grid.clear();
+    for (uint32_t t = 0; t < _trails.size(); t++) {
+        const auto& trail = _trails[t];
+        for (uint32_t r = 0; r < trail.runs().size(); r++) {
+            const auto& run = trail.runs()[r];
+            SegmentGrid::CellRange prev = {1, 1, 0, 0};
+            for (uint32_t k = 0; k < run.count; k++) prev = _grid.insert({t, r | SegmentRef::RUN}, run.dash(k), prev);
+        }
+        for (uint32_t seg = 0; seg < trail.size(); seg++) _lastCells[t] = _grid.insert({t, seg}, trail[seg]);
     }
+    return removed;
 }
 
-const std::vector<Player>& World::players() const { return _players; }
+template <size_t N>
+void BasicWorld<N>::save(Checkpoint& c) const {
+    c.players = _players;
+    c.idToIdx = _idToIdx;
+    c.trailIdx = _trailIdx;
+    c.trails.clear();
+    for (const auto& trail : _trails) {
+        const size_t n = trail.size();
+        if (n == 0) {
+            c.trails.push_back({0, 0.0f, 0.0f, 0.0f, 0.0f});
+        } else {
+            const Line last = trail[n - 1];
+            c.trails.push_back({(uint32_t)n, last.start().x(), last.start().y(), last.end().x(), last.end().y()});
+        }
+    }
+    c.lastCells = _lastCells;
+    c.gridEntries = _grid.entries();
+    c.curTime = _curTime;
+    c.drawing = _drawing;
+    c.clearance = _clearance;
+    c.sweepOrder = _sweepOrder;
+    c.stats = _stats;
+    c.hash = _hash;
+}
 
-const std::vector<Trail>& World::trails() const { return _trails; }
+template <size_t N>
+void BasicWorld<N>::restore(const Checkpoint& c) {
+    _players = c.players;
+    _idToIdx = c.idToIdx;
+    _trailIdx = c.trailIdx;
+    for (size_t t = 0; t < _trails.size(); t++) {
+        const auto& m = c.trails[t];
+        _trails[t].truncate(m.size, Line(mathfu::vec2(m.sx, m.sy), mathfu::vec2(m.ex, m.ey)));
+    }
+    _lastCells = c.lastCells;
+    _grid.truncate(c.gridEntries);
+    _curTime = c.curTime;
+    _drawing = c.drawing;
+    _clearance = c.clearance;
+    _sweepOrder = c.sweepOrder;
+    _stats = c.stats;
+    _hash = c.hash;
+}
+
+template <size_t N>
+void BasicWorld<N>::snapshot(WorldSnapshot& s) const {
+    WorldSnapshot::Header h = {};
+    h.players = _players.size();
+    h.trails = _trails.size();
+    for (const auto& trail : _trails) {
+        h.segments += trail.size();
+        h.runs += trail.runs().size();
+    }
+    h.gridCells = _grid.cells();
+    h.gridEntries = _grid.entries();
+    h.size = _size;
+    h.dashTime = _dashTime;
+    h.curTime = _curTime;
+    h.checked = _stats.checked;
+    h.skipped = _stats.skipped;
+    h.hash = _hash;
+    h.drawing = _drawing;
+    h.kinematics = (uint32_t)_kinematics;
+    s.reset(h);
+
+    WorldSnapshot::PlayerState* players = s.players();
+    for (size_t i = 0; i < _players.size(); i++) {
+        const Cycle& c = _players[i].cycle;
+        const auto& f = c.fixedState();
+        players[i] = {_players[i].id,     _trailIdx[i],       c.pos().x(),       c.pos().y(), c.heading().x(),
+                      c.heading().y(), _clearance[i].stat, _clearance[i].dyn, _sweepOrder[i], f.x,
+                      f.y,             f.angle};
+    }
+
+    WorldSnapshot::TrailState* trails = s.trails();
+    WorldSnapshot::Segment* seg = s.segments();
+    WorldSnapshot::Run* run = s.runs();
+    for (size_t t = 0; t < _trails.size(); t++) {
+        const Trail& trail = _trails[t];
+        const auto& cells = _lastCells[t];
+        trails[t] = {(uint32_t)trail.size(), (uint32_t)trail.runs().size(), {cells.x0, cells.y0, cells.x1, cells.y1}};
+        for (size_t b = 0; b < trail.blocks(); b++) {
+            const size_t n = std::min(Trail::BLOCK, trail.size() - b * Trail::BLOCK);
+            const float *sx = trail.sx(b), *sy = trail.sy(b), *ex = trail.ex(b), *ey = trail.ey(b);
+            for (size_t k = 0; k < n; k++) *seg++ = {sx[k], sy[k], ex[k], ey[k]};
+        }
+        for (const auto& r : trail.runs()) {
+            *run++ = {r.start.x(), r.start.y(), r.dir.x(), r.dir.y(), r.length, r.period, r.count};
+        }
+    }
+
+    _grid.save(s.gridHeads(), s.gridNodes());
+}
+
+template <size_t N>
+void BasicWorld<N>::load(const WorldSnapshotView& s) {
+    using namespace mathfu;
+
+    // the view checked that the snapshot is consistent in itself, what's left
+    // is whether it fits this world, checked before anything is changed
+    const auto& h = s.header();
+    const auto& roster = *_roster;
+    if (h.trails != roster.size()) throw std::invalid_argument("Snapshot is of a world with other players");
+    if (N != 0 && h.players > N) throw std::length_error("Snapshot has more players than the world can hold");
+    for (size_t i = 0; i < h.players; i++) {
+        const auto& p = s.players()[i];
+        if (roster[p.trail].id != p.id) throw std::invalid_argument("Snapshot is of a world with other players");
+    }
+    if (h.kinematics > (uint32_t)Kinematics::Fixed) throw std::invalid_argument("Snapshot has unknown kinematics");
+    // snapshots are of the same match, so the arena is this world's too
+    if (h.size != _size || h.dashTime != _dashTime || h.gridCells != _grid.cells()) {
+        throw std::invalid_argument("Snapshot is of a world with another arena");
+    }
+
+    _players.clear();
+    _trailIdx.clear();
+    _clearance.clear();
+    _sweepOrder.clear();
+    if constexpr (N == 0) _idToIdx.assign(_idToIdx.size(), -1);
+    const WorldSnapshot::PlayerState* players = s.players();
+    for (size_t i = 0; i < h.players; i++) {
+        const auto& p = players[i];
+        const Cycle c = Cycle::withHeading(vec2(p.px, p.py), vec2(p.hx, p.hy), {p.fx, p.fy, p.angle});
+        _players.push_back({c, p.id});
+        _trailIdx.push_back(p.trail);
+        _clearance.push_back({p.clearStat, p.clearDyn});
+        _sweepOrder.push_back(p.sweepOrder);
+        if constexpr (N == 0) _idToIdx[p.id] = i;
+    }
+
+    const WorldSnapshot::TrailState* trails = s.trails();
+    const WorldSnapshot::Segment* seg = s.segments();
+    const WorldSnapshot::Run* run = s.runs();
+    for (size_t t = 0; t < _trails.size(); t++) {
+        Trail& trail = _trails[t];
+        const auto& ts = trails[t];
+        trail.clear();
+        for (uint32_t k = 0; k < ts.segments; k++, seg++) {
+            trail.add(Line(vec2(seg->sx, seg->sy), vec2(seg->ex, seg->ey)));
+        }
+        std::vector<DashedRun> runs;
+        runs.reserve(ts.runs);
+        for (uint32_t k = 0; k < ts.runs; k++, run++) {
+            runs.push_back({vec2(run->sx, run->sy), vec2(run->dx, run->dy), run->length, run->period, run->count});
+        }
+        trail.setRuns(std::move(runs));
+        _lastCells[t] = {ts.lastCells[0], ts.lastCells[1], ts.lastCells[2], ts.lastCells[3]};
+    }
+
+    _grid.load(s.gridHeads(), s.gridNodes(), h.gridEntries);
+    _kinematics = (Kinematics)h.kinematics;
+    _curTime = h.curTime;
+    _drawing = h.drawing;
+    _stats = {h.checked, h.skipped};
+    _hash = h.hash;
+}
+
+template <size_t N>
+void BasicWorld<N>::updateClearance(size_t i) {
+    using namespace mathfu;
+
+    auto& s = _scratch;
+    const Line& line = s.cycLines[i];
+    const uint32_t own = _trailIdx[i];
+
+    // Segments of a cycle's own trail can only be reached again after it drives
+    // a loop, which takes at least pi * radius to come back around. If one dash
+    // period plus a gap plus the cycle fits in that, the last segment of its
+    // own trail can't be hit while the certificate lasts, as long as it lasts
+    // no longer than a period. The one it's still drawing never can.
+    const double period = 2 * _dashTime * CYCLE_SPEED;
+    const double turnRadius = CYCLE_SPEED / (TURN_SPEED * M_PI / 180.0);
+    const bool ownLastSafe = _dashTime > 0.0 && 1.5 * period + CYCLE_LENGTH < M_PI * turnRadius;
+    const float cap = ownLastSafe ? std::min(MAX_CLEARANCE, period) : MAX_CLEARANCE;
+
+    // arena edges, the nearest is always closest to one of the ends
+    const float sizeDiv2 = _size / 2;
+    float stat = cap;
+    for (const auto& p : {line.start(), line.end()}) {
+        stat = std::min(stat, sizeDiv2 - std::max(std::fabs(p.x()), std::fabs(p.y())));
+    }
+
+    // other cycles further away than MAX_CLEARANCE never made it into a near pair
+    float dyn = std::min(cap, s.nearCycle[i]);
+
+    const vec2 lo = vec2::Min(line.start(), line.end()) - vec2(cap, cap);
+    const vec2 hi = vec2::Max(line.start(), line.end()) + vec2(cap, cap);
+    s.nearby.clear();
+    _grid.query(lo, hi, s.nearby);
+    for (const auto& ref : s.nearby) {
+        const auto& trail = _trails[ref.trail];
+        // runs are only ever made of finished segments
+        if (ref.seg & SegmentRef::RUN) {
+            const auto& run = trail.runs()[ref.seg & ~SegmentRef::RUN];
+            auto near = run.dashesNear(lo, hi);
+            for (uint32_t k = near.first; k < near.second; k++) {
+                stat = std::min(stat, (float)Line::distance(line, run.dash(k)));
+            }
+            continue;
+        }
+        const bool last = ref.seg == trail.size() - 1;
+        if (ref.trail == own && last && (ownLastSafe || _drawing)) continue;
+        float d = Line::distance(line, trail[ref.seg]);
+        if (last && s.liveTrail[ref.trail]) {
+            dyn = std::min(dyn, d);
+        } else {
+            stat = std::min(stat, d);
+        }
+    }
+
+    _clearance[i] = {stat, dyn};
+}
+
+template <size_t N>
+int BasicWorld<N>::indexOf(int id) const {
+    if constexpr (N == 0) {
+        return id >= 0 && (size_t)id < _idToIdx.size() ? _idToIdx[id] : -1;
+    } else {
+        for (size_t i = 0; i < _players.size(); i++) {
+            if (_players[i].id == id) return i;
+        }
+        return -1;
+    }
+}
+
+template <size_t N>
+auto BasicWorld<N>::players() const -> const PerPlayer<CycleState>& {
+    return _players;
+}
+
+template <size_t N>
+const Roster& BasicWorld<N>::roster() const {
+    return *_roster;
+}
+
+template <size_t N>
+auto BasicWorld<N>::trails() const -> const PerPlayer<Trail>& {
+    return _trails;
+}
+
+template <size_t N>
+double BasicWorld<N>::size() const {
+    return _size;
+}
+
+template <size_t N>
+Kinematics BasicWorld<N>::kinematics() const {
+    return _kinematics;
+}
+
+template <size_t N>
+const CollisionStats& BasicWorld<N>::collisionStats() const {
+    return _stats;
+}
+
+template <size_t N>
+uint64_t BasicWorld<N>::stateHash() const {
+    return _hash;
+}
+
+template <size_t N>
+size_t BasicWorld<N>::unsharedBytes(const BasicWorld& other) const {
+    using util::heapBytes;
+
+    // arrays a world owns outright, copies only ever get their own
+    size_t bytes = heapBytes(_players) + heapBytes(_idToIdx) + heapBytes(_trailIdx) + heapBytes(_trails) +
+                   heapBytes(_lastCells) + heapBytes(_clearance) + heapBytes(_sweepOrder);
+    const auto& s = _scratch;
+    bytes += heapBytes(s.inputs) + heapBytes(s.prevCycles) + heapBytes(s.prevLines) + heapBytes(s.cycLines) +
+             heapBytes(s.turns) + heapBytes(s.steps) + heapBytes(s.moving) + heapBytes(s.movingTurns) +
+             heapBytes(s.skip) + heapBytes(s.liveTrail) + heapBytes(s.sweep) + heapBytes(s.sweepStart) +
+             heapBytes(s.kill) + heapBytes(s.boxLo) + heapBytes(s.boxHi) + heapBytes(s.nearPairs) +
+             heapBytes(s.nearCycle) + heapBytes(s.nearby) + s.batch.heapBytes();
+
+    // trails line up between worlds of the same match, any other has nothing to share
+    static const Trail none;
+    for (size_t t = 0; t < _trails.size(); t++) {
+        bytes += _trails[t].unsharedBytes(t < other._trails.size() ? other._trails[t] : none);
+    }
+    return bytes + _grid.unsharedBytes(other._grid);
+}
+
+template <size_t N>
+size_t BasicWorld<N>::Checkpoint::heapBytes() const {
+    using util::heapBytes;
+    return heapBytes(players) + heapBytes(idToIdx) + heapBytes(trailIdx) + heapBytes(trails) + heapBytes(lastCells) +
+           heapBytes(clearance) + heapBytes(sweepOrder);
+}
 
-double World::size() const { return _size; }
+template class BasicWorld<0>;
+template class BasicWorld<2>;
+template class BasicWorld<4>;
 
 }  // namespace lcycle
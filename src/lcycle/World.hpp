@@ -1,51 +1,250 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
-#include <string>
+#include <memory>
 #include <utility>
 #include <vector>
 
 #include <mathfu/glsl_mappings.h>
 
 #include "Cycle.hpp"
+#include "Roster.hpp"
+#include "SegmentBatch.hpp"
+#include "SegmentGrid.hpp"
 #include "Trail.hpp"
+#include "WorldSnapshot.hpp"
+#include "util/FixedVector.hpp"
 
 namespace lcycle {
 
-struct Player {
-    using Color = mathfu::vec4;
-
+/*! What the simulation keeps of a living player, see Roster for the rest. */
+struct CycleState {
     Cycle cycle;
     int id;
-    std::string name;
-    Color color;
-    Color tColor;
 };
 
-class World {
+/*! How many per-cycle collision checks runFor ran, and how many it could prove unnecessary. */
+struct CollisionStats {
+    uint64_t checked = 0;
+    uint64_t skipped = 0;
+};
+
+using PlayerInputs = std::vector<std::pair<int, CycleInput>>;
+
+/*! How a world moves its cycles. */
+enum class Kinematics : uint32_t {
+    /*! Floating point with libm trig. Only reproducible on the same build. */
+    Float,
+    /*!
+     * Fixed point with table driven trig, see Cycle::steerFixed. Together
+     * with the collision code sticking to correctly rounded IEEE operations,
+     * a match plays out bit for bit the same on every build, so peers and
+     * replays only need to share inputs.
+     */
+    Fixed,
+};
+
+/*!
+ * The simulation. N is the most players the world can hold, with every
+ * per-player array stored inline and every per-player loop bounded by N, or 0
+ * for no limit at all. Only the counts instantiated in World.cpp are
+ * available, see World below.
+ */
+template <size_t N>
+class BasicWorld {
    public:
-    using PlayerInputs = std::vector<std::pair<int, CycleInput>>;
+    using PlayerInputs = lcycle::PlayerInputs;
+    template <typename T>
+    using PerPlayer = util::SmallVector<T, N>;
 
-    World(double size, double dashTime, const std::vector<Player>& players);
-    World();
+    /*!
+     * Throws std::length_error if N isn't 0 and there are more than N players,
+     * or std::invalid_argument if their ids aren't unique, non-negative and at
+     * most Roster::MAX_ID.
+     */
+    BasicWorld(double size, double dashTime, const std::vector<Player>& players,
+               Kinematics kinematics = Kinematics::Float);
+    BasicWorld();
 
-    World(const World& other) = default;
-    World& operator=(const World& other) = default;
-    World(World&& other) = default;
-    World& operator=(World&& other) = default;
+    BasicWorld(const BasicWorld& other) = default;
+    BasicWorld& operator=(const BasicWorld& other) = default;
+    BasicWorld(BasicWorld&& other) = default;
+    BasicWorld& operator=(BasicWorld&& other) = default;
+
+    /*!
+     * Preallocates room for segmentsPerTrail segments in every trail, after
+     * which runFor doesn't touch the heap until a trail outgrows it.
+     */
+    void reserve(size_t segmentsPerTrail);
 
     void runFor(double secs, const PlayerInputs& inputs);
-    const std::vector<Player>& players() const;
-    const std::vector<Trail>& trails() const;
+    /*!
+     * Folds long straight stretches of every trail into DashedRuns (see
+     * Trail::compact) and rebuilds the segment grid to match. Costs a pass over
+     * every segment, so call it every few seconds of play rather than every
+     * tick. Returns how many segments were removed.
+     */
+    size_t compact(float tolerance = 1e-3f);
+
+    /*!
+     * Everything runFor changes. What it appends to trails and the grid is
+     * only recorded as lengths, so saving and restoring cost O(players) plus
+     * whatever was appended in between. Compacting invalidates every earlier
+     * checkpoint.
+     */
+    struct Checkpoint;
+    void save(Checkpoint& c) const;
+    /*! Puts the world back the way it was when c was saved. */
+    void restore(const Checkpoint& c);
+
+    /*! Writes everything runFor and compact change into s, see WorldSnapshot. */
+    void snapshot(WorldSnapshot& s) const;
+    /*!
+     * Replaces the simulated state with the one in s, taking names and colours
+     * from the players this world was created with. s may be a WorldSnapshot
+     * or a view of one read from anywhere, and is checked before anything
+     * changes. Throws std::invalid_argument if s wasn't taken from a world
+     * with the same players, arena size and dash time, or is corrupt, or std::length_error if it has more
+     * than N living players.
+     */
+    void load(const WorldSnapshotView& s);
+
+    /*! The players still alive. */
+    const PerPlayer<CycleState>& players() const;
+    /*! Every player the world was created with, dead or alive. */
+    const Roster& roster() const;
+    const PerPlayer<Trail>& trails() const;
     double size() const;
+    Kinematics kinematics() const;
+    const CollisionStats& collisionStats() const;
+    /*!
+     * Checksum of everything the world went through: its arena, every cycle's
+     * position and heading after each runFor, and each segment runFor added or
+     * extended. Worlds that started alike and were run with the same inputs
+     * agree on it, a world that drifted apart won't. Kept up to date at
+     * O(players) per runFor; compact doesn't change it.
+     */
+    uint64_t stateHash() const;
+    /*!
+     * Heap bytes this world holds that other doesn't share: its trail and
+     * grid blocks other has no part in, and its own per-player and working
+     * arrays. For a world copied from other and run a frame, that's what the
+     * copy cost. The roster and allocator overhead aren't counted.
+     */
+    size_t unsharedBytes(const BasicWorld& other) const;
+
+   private:
+    /*!
+     * Lower bounds on how far a cycle can move before it could hit anything.
+     * stat covers the arena edges and segments that no longer change, dyn
+     * covers other cycles and the segments they're still drawing, which can
+     * close in as fast as the cycle itself.
+     */
+    struct Clearance {
+        float stat;
+        float dyn;
+    };
+
+   public:
+    struct Checkpoint {
+        // length of a trail and its last segment, which may have grown since
+        struct TrailMark {
+            uint32_t size;
+            float sx, sy, ex, ey;
+        };
+
+        PerPlayer<CycleState> players;
+        std::vector<int> idToIdx;
+        PerPlayer<uint32_t> trailIdx;
+        PerPlayer<TrailMark> trails;
+        PerPlayer<SegmentGrid::CellRange> lastCells;
+        size_t gridEntries;
+        double curTime;
+        bool drawing;
+        PerPlayer<Clearance> clearance;
+        PerPlayer<uint32_t> sweepOrder;
+        CollisionStats stats;
+        uint64_t hash;
+
+        /*! Bytes of the per-player arrays on the heap, none with a player limit. */
+        size_t heapBytes() const;
+    };
 
    private:
-    std::vector<Player> _players;
-    std::vector<Trail> _trails;
+    // one bit per player
+    using Mask = util::SmallVector<uint64_t, (N + 63) / 64>;
+
+    /*! Working storage for runFor, kept between ticks so they don't allocate. Never copied, only moved. */
+    struct Scratch {
+        Scratch() = default;
+        Scratch(const Scratch&) {}
+        Scratch& operator=(const Scratch&) { return *this; }
+        Scratch(Scratch&&) = default;
+        Scratch& operator=(Scratch&&) = default;
+
+        std::vector<std::pair<int, CycleInput>> inputs;
+        PerPlayer<Cycle> prevCycles;
+        PerPlayer<Line> prevLines;
+        PerPlayer<Line> cycLines;
+        PerPlayer<double> turns;
+        PerPlayer<double> steps;
+        PerPlayer<Cycle*> moving;
+        PerPlayer<double> movingTurns;
+        Mask skip;
+        PerPlayer<uint8_t> liveTrail;
+        std::vector<mathfu::vec2> sweep;
+        util::SmallVector<size_t, N == 0 ? 0 : N + 1> sweepStart;
+        Mask kill;
+        PerPlayer<mathfu::vec2> boxLo;
+        PerPlayer<mathfu::vec2> boxHi;
+        std::vector<std::pair<uint32_t, uint32_t>> nearPairs;
+        PerPlayer<float> nearCycle;
+        std::vector<SegmentRef> nearby;
+        SegmentBatch batch;
+    };
+
+    // shared between copies, trail t belongs to (*_roster)[t]
+    std::shared_ptr<const Roster> _roster;
+    PerPlayer<CycleState> _players;
+    // index into _players of each player id, -1 once dead. Only used without
+    // a player limit, limited worlds look ids up in _players directly.
+    std::vector<int> _idToIdx;
+    // trail index of each living player, trails never move once created
+    PerPlayer<uint32_t> _trailIdx;
+    PerPlayer<Trail> _trails;
+    // cells the last segment of each trail has been registered in
+    PerPlayer<SegmentGrid::CellRange> _lastCells;
+    SegmentGrid _grid;
     double _size;
     double _dashTime;
+    Kinematics _kinematics;
     double _curTime;
     bool _drawing;
+    // parallel to _players
+    PerPlayer<Clearance> _clearance;
+    // player indices by the left edge of their swept box on the last frame, for sort and sweep
+    PerPlayer<uint32_t> _sweepOrder;
+    CollisionStats _stats;
+    uint64_t _hash;
+    Scratch _scratch;
+
+    /*! Steers every cycle with an input this frame by its entry in the turns scratch, in one batch. */
+    void updateCycles(double secs);
+    /*! Steers c for secs by turn degrees the way _kinematics says. */
+    void steer(Cycle& c, double secs, double turn) const;
+    /*! Index into _players of the living player with this id, or -1. */
+    int indexOf(int id) const;
+    void updateClearance(size_t i);
+    /*! Folds the dash schedule and every living cycle into _hash. */
+    void hashCycles();
 };
 
+/*! Specializations for the player counts most matches are played with. */
+extern template class BasicWorld<0>;
+extern template class BasicWorld<2>;
+extern template class BasicWorld<4>;
+
+using World = BasicWorld<0>;
+
 }  // namespace lcycle
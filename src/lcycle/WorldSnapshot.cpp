@@ -0,0 +1,229 @@
+#include "WorldSnapshot.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SegmentGrid.hpp"
+
+namespace lcycle {
+
+static size_t roundUp8(size_t n) { return (n + 7) / 8 * 8; }
+
+WorldSnapshot::WorldSnapshot() : _buf(), _layout() {
+    Header h = {};
+    reset(h);
+}
+
+WorldSnapshot::Layout WorldSnapshot::layout(const Header& h) {
+    Layout l;
+    l.players = roundUp8(sizeof(Header));
+    l.trails = roundUp8(l.players + h.players * sizeof(PlayerState));
+    l.segments = roundUp8(l.trails + h.trails * sizeof(TrailState));
+    l.runs = roundUp8(l.segments + h.segments * sizeof(Segment));
+    l.gridHeads = roundUp8(l.runs + h.runs * sizeof(Run));
+    l.gridNodes = roundUp8(l.gridHeads + h.gridCells * sizeof(uint32_t));
+    l.end = roundUp8(l.gridNodes + h.gridEntries * sizeof(SegmentGrid::Node));
+    return l;
+}
+
+bool WorldSnapshot::validArena(double size, double dashTime) {
+    // written so NaNs fail every comparison
+    const bool dashes = dashTime >= MIN_DASH_TIME && std::isfinite(dashTime);
+    return size > 0.0 && size <= MAX_SIZE && (dashTime == 0.0 || dashes);
+}
+
+void WorldSnapshot::reset(const Header& h) {
+    _layout = layout(h);
+    // zeroed, so the gaps between sections hash the same every time
+    _buf.assign(_layout.end / 8, 0);
+    Header& dst = *at<Header>(0);
+    dst = h;
+    dst.magic = MAGIC;
+    dst.version = VERSION;
+}
+
+void WorldSnapshot::assign(const void* data, size_t bytes) {
+    Header h;
+    if (bytes < sizeof(Header)) throw std::invalid_argument("Snapshot is truncated");
+    std::memcpy(&h, data, sizeof(Header));
+    if (h.magic != MAGIC || h.version != VERSION) throw std::invalid_argument("Not a world snapshot");
+    if (bytes != layout(h).end) throw std::invalid_argument("Snapshot size doesn't match its header");
+    _buf.resize(bytes / 8);
+    std::memcpy(_buf.data(), data, bytes);
+    _layout = layout(h);
+    // now that it's aligned, check the rest, and don't keep it if it's bad
+    try {
+        WorldSnapshotView(_buf.data(), bytes);
+    } catch (...) {
+        Header empty = {};
+        reset(empty);
+        throw;
+    }
+}
+
+void WorldSnapshot::save(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("Can't open " + path);
+    const bool ok = std::fwrite(data(), 1, bytes(), f) == bytes();
+    if (std::fclose(f) != 0 || !ok) throw std::runtime_error("Can't write " + path);
+}
+
+const void* WorldSnapshot::data() const { return _buf.data(); }
+
+size_t WorldSnapshot::bytes() const { return _layout.end; }
+
+uint64_t WorldSnapshot::hash() const {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (uint64_t word : _buf) {
+        h ^= word;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+WorldSnapshotView WorldSnapshot::view() const { return WorldSnapshotView(*this); }
+
+const WorldSnapshot::Header& WorldSnapshot::header() const { return view().header(); }
+
+const WorldSnapshot::PlayerState* WorldSnapshot::players() const { return view().players(); }
+
+const WorldSnapshot::TrailState* WorldSnapshot::trails() const { return view().trails(); }
+
+const WorldSnapshot::Segment* WorldSnapshot::segments() const { return view().segments(); }
+
+const WorldSnapshot::Run* WorldSnapshot::runs() const { return view().runs(); }
+
+const uint32_t* WorldSnapshot::gridHeads() const { return view().gridHeads(); }
+
+const SegmentGrid::Node* WorldSnapshot::gridNodes() const { return view().gridNodes(); }
+
+WorldSnapshot::PlayerState* WorldSnapshot::players() { return at<PlayerState>(_layout.players); }
+
+WorldSnapshot::TrailState* WorldSnapshot::trails() { return at<TrailState>(_layout.trails); }
+
+WorldSnapshot::Segment* WorldSnapshot::segments() { return at<Segment>(_layout.segments); }
+
+WorldSnapshot::Run* WorldSnapshot::runs() { return at<Run>(_layout.runs); }
+
+uint32_t* WorldSnapshot::gridHeads() { return at<uint32_t>(_layout.gridHeads); }
+
+SegmentGrid::Node* WorldSnapshot::gridNodes() { return at<SegmentGrid::Node>(_layout.gridNodes); }
+
+WorldSnapshotView::WorldSnapshotView(const void* data, size_t bytes)
+    : _data(static_cast<const unsigned char*>(data)), _bytes(bytes), _layout() {
+    using Header = WorldSnapshot::Header;
+
+    if (reinterpret_cast<uintptr_t>(data) % 8 != 0) throw std::invalid_argument("Snapshot isn't 8 byte aligned");
+    if (bytes < sizeof(Header)) throw std::invalid_argument("Snapshot is truncated");
+    const Header& h = header();
+    if (h.magic != WorldSnapshot::MAGIC || h.version != WorldSnapshot::VERSION) {
+        throw std::invalid_argument("Not a world snapshot");
+    }
+    _layout = WorldSnapshot::layout(h);
+    if (bytes != _layout.end) throw std::invalid_argument("Snapshot size doesn't match its header");
+    if (!WorldSnapshot::validArena(h.size, h.dashTime) || !std::isfinite(h.curTime)) {
+        throw std::invalid_argument("Snapshot arena is out of range");
+    }
+    // the grid is the one a world of this size has
+    const int32_t dim = SegmentGrid::dimFor(h.size);
+    if ((uint64_t)dim * dim != h.gridCells) throw std::invalid_argument("Snapshot grid doesn't match its arena");
+
+    uint64_t segments = 0, runs = 0;
+    for (uint32_t t = 0; t < h.trails; t++) {
+        segments += trails()[t].segments;
+        runs += trails()[t].runs;
+    }
+    if (segments != h.segments || runs != h.runs) throw std::invalid_argument("Snapshot trails don't add up");
+
+    // every living player has a trail of its own and an id of its own, and
+    // while drawing, a segment in it to extend
+    if (h.players > h.trails) throw std::invalid_argument("Snapshot has more players than trails");
+    std::vector<bool> owned(h.trails);
+    std::vector<int32_t> ids(h.players);
+    for (uint32_t i = 0; i < h.players; i++) {
+        const WorldSnapshot::PlayerState& p = players()[i];
+        if (p.trail >= h.trails || p.sweepOrder >= h.players) {
+            throw std::invalid_argument("Snapshot player is out of range");
+        }
+        if (owned[p.trail]) throw std::invalid_argument("Snapshot players share a trail");
+        owned[p.trail] = true;
+        if (h.drawing && trails()[p.trail].segments == 0) {
+            throw std::invalid_argument("Snapshot player is drawing without a trail");
+        }
+        ids[i] = p.id;
+    }
+    std::sort(ids.begin(), ids.end());
+    if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) {
+        throw std::invalid_argument("Snapshot players share an id");
+    }
+
+    // every node has to point at a node before it and a segment or run that
+    // exists, so loading the grid can't walk out of bounds
+    for (uint32_t t = 0; t < h.trails; t++) {
+        const int32_t* c = trails()[t].lastCells;
+        const bool empty = c[0] > c[2] || c[1] > c[3];
+        if (!empty && (c[0] < 0 || c[1] < 0 || c[2] >= dim || c[3] >= dim)) {
+            throw std::invalid_argument("Snapshot grid is corrupt");
+        }
+    }
+    const uint32_t* heads = gridHeads();
+    bool corrupt = false;
+    // an empty cell's ~0 wraps around to 0, so this is one compare per cell
+    for (uint32_t c = 0; c < h.gridCells; c++) corrupt |= heads[c] + 1 > h.gridEntries;
+    const WorldSnapshot::TrailState* ts = trails();
+    const SegmentGrid::Node* nodes = gridNodes();
+    for (uint32_t k = 0; k < h.gridEntries && !corrupt; k++) {
+        const SegmentGrid::Node& n = nodes[k];
+        if ((n.next != ~0u && n.next >= k) || n.cell >= h.gridCells || n.ref.trail >= h.trails) {
+            throw std::invalid_argument("Snapshot grid is corrupt");
+        }
+        const uint32_t idx = n.ref.seg & ~SegmentRef::RUN;
+        corrupt = idx >= (n.ref.seg & SegmentRef::RUN ? ts[n.ref.trail].runs : ts[n.ref.trail].segments);
+    }
+    if (corrupt) throw std::invalid_argument("Snapshot grid is corrupt");
+}
+
+WorldSnapshotView::WorldSnapshotView(const WorldSnapshot& s)
+    : _data(static_cast<const unsigned char*>(s.data())), _bytes(s.bytes()), _layout(s._layout) {}
+
+const void* WorldSnapshotView::data() const { return _data; }
+
+size_t WorldSnapshotView::bytes() const { return _bytes; }
+
+const WorldSnapshot::Header& WorldSnapshotView::header() const { return *at<WorldSnapshot::Header>(0); }
+
+const WorldSnapshot::PlayerState* WorldSnapshotView::players() const {
+    return at<WorldSnapshot::PlayerState>(_layout.players);
+}
+
+const WorldSnapshot::TrailState* WorldSnapshotView::trails() const {
+    return at<WorldSnapshot::TrailState>(_layout.trails);
+}
+
+const WorldSnapshot::Segment* WorldSnapshotView::segments() const {
+    return at<WorldSnapshot::Segment>(_layout.segments);
+}
+
+const WorldSnapshot::Run* WorldSnapshotView::runs() const { return at<WorldSnapshot::Run>(_layout.runs); }
+
+const uint32_t* WorldSnapshotView::gridHeads() const { return at<uint32_t>(_layout.gridHeads); }
+
+const SegmentGrid::Node* WorldSnapshotView::gridNodes() const { return at<SegmentGrid::Node>(_layout.gridNodes); }
+
+WorldSnapshotView::TrailView WorldSnapshotView::trail(size_t t) const {
+    size_t seg = 0, run = 0;
+    for (size_t k = 0; k < t; k++) {
+        seg += trails()[k].segments;
+        run += trails()[k].runs;
+    }
+    return {segments() + seg, trails()[t].segments, runs() + run, trails()[t].runs};
+}
+
+}  // namespace lcycle
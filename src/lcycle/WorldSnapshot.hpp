@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "SegmentGrid.hpp"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "World snapshots are stored little endian and read in place, which needs a little endian host"
+#endif
+
+namespace lcycle {
+
+class WorldSnapshotView;
+
+/*!
+ * The whole simulated state of a world as plain old data in one contiguous,
+ * 8 byte aligned buffer: a header followed by arrays of players, trails,
+ * segments, dashed runs and the segment grid. Every section starts at a
+ * multiple of 8 bytes and no struct has padding, so the bytes depend only on
+ * the state and copying, hashing or writing a snapshot out is one pass over
+ * the buffer. Names and colours never change during a match and aren't
+ * included; they come from the roster of the world a snapshot is loaded into.
+ *
+ * The bytes are the file format too: little endian, versioned by the header,
+ * and readable in place from a memory mapped file through WorldSnapshotView.
+ */
+class WorldSnapshot {
+   public:
+    static constexpr uint32_t MAGIC = 0x4c435753;  // "LCWS"
+    static constexpr uint32_t VERSION = 3;
+    /*!
+     * The biggest arena and shortest dash a snapshot or replay file may
+     * have, which bounds the grid and the work a frame takes for a world
+     * built from one.
+     */
+    static constexpr double MAX_SIZE = 2048.0;
+    static constexpr double MIN_DASH_TIME = 1.0 / 1000.0;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t players;
+        uint32_t trails;
+        uint32_t segments;
+        uint32_t runs;
+        uint32_t gridCells;
+        uint32_t gridEntries;
+        double size;
+        double dashTime;
+        double curTime;
+        uint64_t checked;
+        uint64_t skipped;
+        // World::stateHash
+        uint64_t hash;
+        uint32_t drawing;
+        // a Kinematics
+        uint32_t kinematics;
+    };
+
+    /*! A living player, in the world's player order. */
+    struct PlayerState {
+        int32_t id;
+        uint32_t trail;
+        float px, py;
+        float hx, hy;
+        float clearStat, clearDyn;
+        uint32_t sweepOrder;
+        // Cycle::FixedState
+        int32_t fx, fy;
+        uint32_t angle;
+    };
+
+    /*! Segments and runs of each trail follow those of the trail before it. */
+    struct TrailState {
+        uint32_t segments;
+        uint32_t runs;
+        int32_t lastCells[4];
+    };
+
+    struct Segment {
+        float sx, sy, ex, ey;
+    };
+
+    struct Run {
+        float sx, sy;
+        float dx, dy;
+        float length;
+        float period;
+        uint32_t count;
+    };
+
+    WorldSnapshot();
+
+    /*!
+     * Whether size is positive and at most MAX_SIZE, and dashTime 0, for no
+     * dashes, or at least MIN_DASH_TIME, and neither is NaN or infinite.
+     */
+    static bool validArena(double size, double dashTime);
+
+    /*! Lays out an empty snapshot with room for the counts in h, which is copied in. */
+    void reset(const Header& h);
+    /*!
+     * Replaces the contents with a copy of a serialized snapshot, which needn't
+     * be aligned. Throws std::invalid_argument if bytes don't hold one, leaving
+     * an empty snapshot behind.
+     */
+    void assign(const void* data, size_t bytes);
+    /*! Writes the bytes to a file. Throws std::runtime_error if that fails. */
+    void save(const std::string& path) const;
+
+    const void* data() const;
+    size_t bytes() const;
+    /*! 64 bit FNV-1a over the buffer, a 64 bit word at a time rather than a byte. */
+    uint64_t hash() const;
+    WorldSnapshotView view() const;
+
+    const Header& header() const;
+    const PlayerState* players() const;
+    const TrailState* trails() const;
+    const Segment* segments() const;
+    const Run* runs() const;
+    const uint32_t* gridHeads() const;
+    const SegmentGrid::Node* gridNodes() const;
+
+    PlayerState* players();
+    TrailState* trails();
+    Segment* segments();
+    Run* runs();
+    uint32_t* gridHeads();
+    SegmentGrid::Node* gridNodes();
+
+   private:
+    friend class WorldSnapshotView;
+
+    // byte offsets of each section, derived from the header's counts
+    struct Layout {
+        size_t players, trails, segments, runs, gridHeads, gridNodes, end;
+    };
+
+    static Layout layout(const Header& h);
+
+    template <typename T>
+    T* at(size_t offset) {
+        return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(_buf.data()) + offset);
+    }
+
+    std::vector<uint64_t> _buf;
+    Layout _layout;
+};
+
+/*!
+ * Read only access to a serialized snapshot where it lies, typically a
+ * memory mapped file, without copying or converting anything. Only valid as
+ * long as the bytes it was made from.
+ */
+class WorldSnapshotView {
+   public:
+    /*! One trail's segments and runs. */
+    struct TrailView {
+        const WorldSnapshot::Segment* segments;
+        uint32_t nSegments;
+        const WorldSnapshot::Run* runs;
+        uint32_t nRuns;
+    };
+
+    /*!
+     * Checks that data holds a snapshot of this version whose counts add up,
+     * whose arena is valid and its grid the size for it, whose players each
+     * have a trail and id of their own, with a segment to extend while
+     * drawing, and whose grid only refers to things that exist, which is one
+     * pass over everything but the segments and runs. Throws
+     * std::invalid_argument if not, or if data isn't 8 byte aligned.
+     */
+    WorldSnapshotView(const void* data, size_t bytes);
+    /*! Views a snapshot in memory, which is trusted, implicitly so it can be passed wherever a view is taken. */
+    WorldSnapshotView(const WorldSnapshot& s);
+
+    const void* data() const;
+    size_t bytes() const;
+
+    const WorldSnapshot::Header& header() const;
+    const WorldSnapshot::PlayerState* players() const;
+    const WorldSnapshot::TrailState* trails() const;
+    const WorldSnapshot::Segment* segments() const;
+    const WorldSnapshot::Run* runs() const;
+    const uint32_t* gridHeads() const;
+    const SegmentGrid::Node* gridNodes() const;
+    /*! Segments and runs of trail t, found by walking the trails before it. */
+    TrailView trail(size_t t) const;
+
+   private:
+    template <typename T>
+    const T* at(size_t offset) const {
+        return reinterpret_cast<const T*>(_data + offset);
+    }
+
+    const unsigned char* _data;
+    size_t _bytes;
+    WorldSnapshot::Layout _layout;
+};
+
+static_assert(std::is_trivially_copyable<WorldSnapshot::Header>::value, "");
+static_assert(std::is_trivially_copyable<WorldSnapshot::PlayerState>::value, "");
+static_assert(std::is_trivially_copyable<WorldSnapshot::TrailState>::value, "");
+static_assert(std::is_trivially_copyable<WorldSnapshot::Segment>::value, "");
+static_assert(std::is_trivially_copyable<WorldSnapshot::Run>::value, "");
+static_assert(std::is_trivially_copyable<SegmentGrid::Node>::value, "");
+static_assert(sizeof(WorldSnapshot::Header) == 88, "snapshot header has padding");
+static_assert(sizeof(WorldSnapshot::PlayerState) == 48, "snapshot player has padding");
+static_assert(sizeof(SegmentGrid::Node) == 16, "grid node has padding");
+
+}  // namespace lcycle
@@ -3,7 +3,11 @@
 #include <GLFW/glfw3.h>
 // clang-format on
 
+#include <algorithm>
+#include <cmath>
+#include <ctime>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
 
@@ -18,7 +22,10 @@
 #include "input/KeyState.hpp"
 
 #include "lcycle/Cycle.hpp"
-#include "lcycle/RollbackWorld.hpp"
+#include "lcycle/InputLog.hpp"
+#include "lcycle/JournalRollbackWorld.hpp"
+#include "lcycle/Replay.hpp"
+#include "lcycle/ReplayFile.hpp"
 #include "lcycle/World.hpp"
 
 #include "gfx/WorldRenderer.hpp"
@@ -264,23 +271,29 @@ mathfu::mat4 projection(int winWidth, int winHeight, double worldSize) {
     }
 }
 
+template <size_t N>
 struct GameState {
-    lcycle::World initial;
-    lcycle::RollbackWorld rbw;
+    lcycle::BasicWorld<N> initial;
+    lcycle::BasicJournalRollbackWorld<N> rbw;
     std::vector<std::function<lcycle::CycleInput()>> inputs;
-    std::vector<lcycle::World::PlayerInputs> replay;
+    lcycle::BasicReplay<N> replay;
+    // the same match streamed to disk, if the file could be created
+    std::unique_ptr<lcycle::BasicReplayWriter<N>> recording;
     bool running;
 };
 
+template <size_t N>
 struct ReplayState {
-    lcycle::World world;
-    std::vector<lcycle::World::PlayerInputs> replayInputs;
+    lcycle::BasicReplay<N>* replay = nullptr;
+    // negative plays in reverse
     float replaySpeed = 1.0;
-    int replayFrame = 0;
+    // fractional, so slow playback still moves on between frames
+    double replayFrame = 0.0;
     bool running = false;
 };
 
-void replay(GLFWwindow* win, gl::Program& p, ReplayState s) {
+template <size_t N>
+void replay(GLFWwindow* win, gl::Program& p, ReplayState<N> s) {
     using namespace mathfu;
 
     auto* ws = static_cast<WindowState*>(glfwGetWindowUserPointer(win));
@@ -288,12 +301,15 @@ void replay(GLFWwindow* win, gl::Program& p, ReplayState s) {
     int w, h;
     glfwGetFramebufferSize(win, &w, &h);
 
-    double timeSinceLastFrame = 0.0;
     double time = glfwGetTime();
     ws->gui.active = true;
     s.running = false;
-    s.replayFrame = 0;
+    s.replayFrame = 0.0;
     s.replaySpeed = 1.0;
+    // keeps the last second of frames it played, so scrubbing and playing in
+    // reverse rarely have to go back to a keyframe
+    lcycle::BasicReplayCursor<N> cursor(*s.replay);
+    const int nFrames = (int)s.replay->frames();
 
     p.use();
     mat4 mdl = mathfu::mat4::Identity();
@@ -314,7 +330,7 @@ void replay(GLFWwindow* win, gl::Program& p, ReplayState s) {
 
         double curTime = glfwGetTime();
         if (s.running) {
-            timeSinceLastFrame += s.replaySpeed * (curTime - time);
+            s.replayFrame += s.replaySpeed * (curTime - time) / kTimePerFrame;
         }
         time = curTime;
 
@@ -326,30 +342,47 @@ void replay(GLFWwindow* win, gl::Program& p, ReplayState s) {
         if (ws->keys.isPosEdge(GLFW_KEY_P)) {
             s.running = !s.running;
         }
-
-        // Update game
-        if (timeSinceLastFrame >= 0.5 * kTimePerFrame) {
-            while (timeSinceLastFrame >= 0.5 * kTimePerFrame && s.replayFrame < s.replayInputs.size()) {
-                timeSinceLastFrame -= kTimePerFrame;
-                s.world.runFor(kTimePerFrame, s.replayInputs[s.replayFrame]);
-                s.replayFrame++;
-            }
+        if (ws->keys.isPosEdge(GLFW_KEY_R)) {
+            s.replaySpeed = -s.replaySpeed;
+        }
+        if (!s.running && ws->keys.isPosEdge(GLFW_KEY_RIGHT)) {
+            s.replayFrame = std::floor(s.replayFrame) + 1;
+        }
+        if (!s.running && ws->keys.isPosEdge(GLFW_KEY_LEFT)) {
+            s.replayFrame = std::ceil(s.replayFrame) - 1;
         }
 
         // Update UI
         if (ws->gui.active) {
             auto* ctx = &ws->gui.ctx;
+
+            if (nk_begin(ctx, "replay window", {0, h - 80.0f, (float)w, 80.0f}, NK_WINDOW_NO_SCROLLBAR)) {
+                // the timeline, dragging it seeks from the nearest keyframe
+                int frame = (int)s.replayFrame;
+                nk_layout_row_dynamic(ctx, 0, 1);
+                if (nk_slider_int(ctx, 0, &frame, nFrames, 1)) {
+                    s.replayFrame = frame;
+                }
+                nk_layout_row_dynamic(ctx, 0, 2);
+                if (nk_button_label(ctx, "Play")) {
+                    s.running = true;
+                }
+                nk_property_float(ctx, "Speed", -4.0f, &s.replaySpeed, 4.0f, 0.25f, 0.05f);
+            }
+            nk_end(ctx);
         }
+        s.replayFrame = std::max(0.0, std::min((double)nFrames, s.replayFrame));
+        const auto& world = cursor.at((size_t)s.replayFrame);
 
         glViewport(0, 0, w, h);
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Render game
         p.use();
-        mat4 proj = projection(w, h, s.world.size());
+        mat4 proj = projection(w, h, world.size());
         glUniformMatrix4fv(p.getUniform("viewProjection"), 1, false, &(proj * view)[0]);
 
-        ws->wr.render(s.world);
+        ws->wr.render(world);
 
         // Render UI
         if (ws->gui.active) {
@@ -360,7 +393,9 @@ void replay(GLFWwindow* win, gl::Program& p, ReplayState s) {
     }
 }
 
-// Returns true if the players want a rematch
+// Returns true if the players want a rematch. N is the player limit of the
+// world to simulate, 0 for none.
+template <size_t N>
 bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
     using namespace lcycle;
     using namespace gfx;
@@ -400,7 +435,7 @@ bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
     }
 
     auto* windowState = static_cast<WindowState*>(glfwGetWindowUserPointer(win));
-    GameState gs;
+    GameState<N> gs;
     for (auto i = 0u; i < nPlayers; i++) {
         gs.inputs.push_back(INPUTS[i]);
     }
@@ -422,8 +457,17 @@ bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
             playerInputs.push_back(std::make_pair<int, CycleInput>(i, {}));
         }
 
-        gs.initial = World(WORLD_SIZE, 0.14, players);
-        gs.rbw = RollbackWorld(gs.initial);
+        // replays only store inputs, so they have to play back the same on any build
+        gs.initial = BasicWorld<N>(WORLD_SIZE, 0.14, players, Kinematics::Fixed);
+        gs.rbw = BasicJournalRollbackWorld<N>(gs.initial);
+        gs.replay = BasicReplay<N>(gs.initial, kTimePerFrame);
+        const std::string path = "replay-" + std::to_string((long long)std::time(nullptr)) + ".lcr";
+        try {
+            // a keyframe every ten seconds, most matches are over before seeking through them would matter
+            gs.recording = std::make_unique<BasicReplayWriter<N>>(path, gs.initial, kTimePerFrame, 60, 600);
+        } catch (const std::runtime_error& e) {
+            std::cout << "Not recording the match: " << e.what() << std::endl;
+        }
     }
 
     int w, h;
@@ -464,7 +508,8 @@ bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
             break;
         }
         if (gs.rbw.latest()->players().size() == 1) {
-            std::cout << "The winner is: " << gs.rbw.latest()->players()[0].name << std::endl;
+            const auto* world = gs.rbw.latest();
+            std::cout << "The winner is: " << world->roster().byId(world->players()[0].id).name << std::endl;
             gs.running = false;
             break;
         } else if (gs.rbw.latest()->players().size() == 0) {
@@ -478,19 +523,25 @@ bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
         }
 
         if (windowState->keys.isPosEdge(GLFW_KEY_V)) {
-            gs.rbw.rollback(30);
+            // the replay has to forget the frames too, or it'd play them twice
+            if (gs.rbw.rollback(30)) {
+                gs.replay.truncate(gs.rbw.frame());
+                if (gs.recording) gs.recording->truncate(gs.rbw.frame());
+            }
             std::cout << "r-r-rollback" << std::endl;
         }
 
         // Update game
         if (timeSinceLastFrame >= 0.5 * kTimePerFrame) {
+            // quantized, the only way the replay can record them
             for (auto i = 0u; i < nPlayers; i++) {
-                playerInputs[i].second = gs.inputs[i]();
+                playerInputs[i].second = InputLog::quantize(gs.inputs[i]());
             }
             while (timeSinceLastFrame >= 0.5 * kTimePerFrame) {
                 timeSinceLastFrame -= kTimePerFrame;
                 gs.rbw.advance(playerInputs);
-                gs.replay.push_back(playerInputs);
+                gs.replay.record(playerInputs);
+                if (gs.recording) gs.recording->record(playerInputs, *gs.rbw.latest());
                 first_frame = false;
             }
         }
@@ -548,6 +599,14 @@ bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
         glfwSwapBuffers(win);
     }
 
+    if (gs.recording) {
+        try {
+            gs.recording->close();
+        } catch (const std::runtime_error& e) {
+            std::cout << "The replay file is incomplete: " << e.what() << std::endl;
+        }
+    }
+
     bool rematch = false;
     while (!glfwWindowShouldClose(win) && !rematch) {
         windowState->gui.active = true;
@@ -619,9 +678,8 @@ bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
         glfwSwapBuffers(win);
 
         if (watch_replay) {
-            ReplayState rs;
-            rs.replayInputs = gs.replay;
-            rs.world = gs.initial;
+            ReplayState<N> rs;
+            rs.replay = &gs.replay;
             replay(win, p, rs);
         }
     }
@@ -629,6 +687,18 @@ bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
     return rematch;
 }
 
+// Plays on the world specialized for nPlayers if there is one
+bool mainloop(GLFWwindow* win, gl::Program& p, size_t nPlayers) {
+    switch (nPlayers) {
+        case 2:
+            return mainloop<2>(win, p, nPlayers);
+        case 4:
+            return mainloop<4>(win, p, nPlayers);
+        default:
+            return mainloop<0>(win, p, nPlayers);
+    }
+}
+
 int main(int argc, char** argv) {
     using namespace std;
     using namespace gl;
@@ -1,24 +1,112 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
 namespace util {
 
-template <typename T, int N>
+/*!
+ * Ring of up to capacity T, oldest at the head. Room for every slot is
+ * allocated up front but a slot's T is only constructed the first time it's
+ * used. Slots that are removed or overwritten aren't destroyed, so whatever
+ * storage a T owns gets reused the next time its slot comes around.
+ */
+template <typename T>
 class CircularBuffer final {
    public:
-    CircularBuffer() : _buf(), _head(0), _size(0) {}
-    ~CircularBuffer() {}
-    T* head() { return _size > 0 ? &_buf[_head] : nullptr; }
-    T* tail() { return _size > 0 ? &_buf[(_head + _size - 1) % N] : nullptr; }
+    /*! Throws std::invalid_argument if capacity isn't positive. */
+    explicit CircularBuffer(int capacity = 1)
+        : _slots(), _capacity(capacity), _constructed(0), _head(0), _size(0) {
+        if (capacity <= 0) throw std::invalid_argument("CircularBuffer capacity must be positive");
+        _slots.reset(new Slot[capacity]);
+    }
+    CircularBuffer(const CircularBuffer& other) : CircularBuffer(other._capacity) { *this = other; }
+    CircularBuffer(CircularBuffer&& other)
+        : _slots(std::move(other._slots)),
+          _capacity(other._capacity),
+          _constructed(other._constructed),
+          _head(other._head),
+          _size(other._size) {
+        other._constructed = 0;
+        other._size = 0;
+    }
+    CircularBuffer& operator=(const CircularBuffer& other) {
+        if (this == &other) return *this;
+        if (_capacity != other._capacity) {
+            CircularBuffer resized(other._capacity);
+            *this = std::move(resized);
+        }
+        for (int i = 0; i < other._constructed; i++) {
+            if (i < _constructed) {
+                *at(i) = *other.at(i);
+            } else {
+                new (at(i)) T(*other.at(i));
+                _constructed++;
+            }
+        }
+        _head = other._head;
+        _size = other._size;
+        return *this;
+    }
+    CircularBuffer& operator=(CircularBuffer&& other) {
+        if (this == &other) return *this;
+        destroy();
+        _slots = std::move(other._slots);
+        _capacity = other._capacity;
+        _constructed = other._constructed;
+        _head = other._head;
+        _size = other._size;
+        other._constructed = 0;
+        other._size = 0;
+        return *this;
+    }
+    ~CircularBuffer() { destroy(); }
+
+    T* head() { return _size > 0 ? at(_head) : nullptr; }
+    T* tail() { return _size > 0 ? at((_head + _size - 1) % _capacity) : nullptr; }
+    /*! The element k places before the tail, or nullptr if there aren't that many. */
+    const T* fromTail(int k) const {
+        return k >= 0 && k < _size ? at((_head + _size - 1 - k) % _capacity) : nullptr;
+    }
+    T* fromTail(int k) { return k >= 0 && k < _size ? at((_head + _size - 1 - k) % _capacity) : nullptr; }
+    /*!
+     * Makes room for a new tail and returns it. Once full that's the slot of
+     * the oldest element, which is left as it was for the caller to overwrite.
+     */
     T* add() {
-        if (_size < N) {
+        if (_size < _capacity) {
+            // slots are constructed in order and a new tail never lands past
+            // the first unconstructed one, so the constructed slots are always
+            // a prefix
+            if (next() == _constructed) {
+                new (at(_constructed)) T();
+                _constructed++;
+            }
             _size++;
             return tail();
         } else {
-            T* t = &_buf[_head];
-            _head = (_head + 1) % N;
+            T* t = at(_head);
+            _head = (_head + 1) % _capacity;
             return t;
         }
     }
+    /*! Same as add(), but copies or moves v into the new tail rather than default constructing it first. */
+    template <typename U>
+    T* add(U&& v) {
+        if (_size < _capacity && next() == _constructed) {
+            new (at(_constructed)) T(std::forward<U>(v));
+            _constructed++;
+            _size++;
+            return tail();
+        }
+        T* t = add();
+        *t = std::forward<U>(v);
+        return t;
+    }
+    /*! Drops the tail, keeping its slot constructed. */
     bool remove() {
         if (_size > 0) {
             _size--;
@@ -26,10 +114,39 @@ class CircularBuffer final {
         }
         return false;
     }
-    int size() { return _size; }
+    /*! Drops the head, keeping its slot constructed for the tail to reuse once it comes around. */
+    bool removeHead() {
+        if (_size > 0) {
+            _head = (_head + 1) % _capacity;
+            _size--;
+            return true;
+        }
+        return false;
+    }
+    int size() const { return _size; }
+    int capacity() const { return _capacity; }
+    /*! Bytes allocated for the slots themselves, not counting anything a T points to. */
+    size_t bytes() const { return (size_t)_capacity * sizeof(Slot); }
 
    private:
-    T _buf[N];
+    struct Slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    // slot the next tail goes in while there's room
+    int next() const { return (_head + _size) % _capacity; }
+    T* at(int i) { return reinterpret_cast<T*>(_slots[i].bytes); }
+    const T* at(int i) const { return reinterpret_cast<const T*>(_slots[i].bytes); }
+    void destroy() {
+        for (int i = 0; i < _constructed; i++) at(i)->~T();
+        _constructed = 0;
+        _size = 0;
+    }
+
+    std::unique_ptr<Slot[]> _slots;
+    int _capacity;
+    // slots [0, _constructed) hold a T
+    int _constructed;
     int _head;
     int _size;
 };
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*!
+ * Refcounted pointer to a T allocated along with its count, for CowVector.
+ * Unlike std::shared_ptr, whose use_count() is only a relaxed load, unique()
+ * acquires, so a thread that finds itself the last holder also sees every
+ * access other threads made before letting go, and can write in place
+ * without racing with them.
+ */
+template <typename T>
+class CowRef final {
+    struct Counted {
+        template <typename... Args>
+        explicit Counted(Args&&... args) : value(std::forward<Args>(args)...), refs(1) {}
+
+        T value;
+        std::atomic<uint32_t> refs;
+    };
+
+   public:
+    /*! Bytes one allocation takes, count and all. */
+    static constexpr size_t allocationSize() { return sizeof(Counted); }
+
+    template <typename... Args>
+    static CowRef make(Args&&... args) {
+        return CowRef(new Counted(std::forward<Args>(args)...));
+    }
+
+    CowRef() : _p(nullptr) {}
+    CowRef(const CowRef& other) : _p(other._p) {
+        if (_p) _p->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    CowRef(CowRef&& other) noexcept : _p(other._p) { other._p = nullptr; }
+    CowRef& operator=(CowRef other) noexcept {
+        std::swap(_p, other._p);
+        return *this;
+    }
+    ~CowRef() {
+        // release what this holder did to it, and acquire what the others did before deleting it
+        if (_p && _p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete _p;
+    }
+
+    T& operator*() const { return _p->value; }
+    T* operator->() const { return &_p->value; }
+    explicit operator bool() const { return _p != nullptr; }
+    bool operator==(const CowRef& other) const { return _p == other._p; }
+    bool operator!=(const CowRef& other) const { return _p != other._p; }
+    /*! Whether this is the only holder left. */
+    bool unique() const { return _p->refs.load(std::memory_order_acquire) == 1; }
+
+   private:
+    explicit CowRef(Counted* p) : _p(p) {}
+
+    Counted* _p;
+};
+
+/*!
+ * Vector of T stored in refcounted blocks of B elements, aligned to 16 bytes.
+ * Copies share every block and the list of blocks, so copying costs O(1).
+ * Writing to shared storage first clones just the block written to, plus the
+ * list of blocks if that is shared too, so a copy that keeps appending pays
+ * for one block and one list clone at a time. Copies can be written to on
+ * different threads, as long as each copy stays on one.
+ */
+template <typename T, size_t B>
+class CowVector final {
+    static_assert(B > 0 && (B & (B - 1)) == 0, "block size must be a power of two");
+
+   public:
+    struct Block {
+        alignas(16) T items[B];
+    };
+
+    CowVector() : _blocks(), _size(0) {}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    static constexpr size_t blockSize() { return B; }
+    /*! How many blocks hold elements. */
+    size_t blocks() const { return (_size + B - 1) / B; }
+    /*! Elements [b * B, min(size, (b + 1) * B)) as one array. */
+    const T* block(size_t b) const { return (*_blocks)[b]->items; }
+
+    /*!
+     * Heap bytes of this vector's list of blocks and the blocks in it that
+     * other doesn't share, leaving out what the allocator adds. Zero if other
+     * shares everything, which is checked first.
+     */
+    size_t unsharedBytes(const CowVector& other) const {
+        if (!_blocks || _blocks == other._blocks) return 0;
+        size_t bytes = CowRef<Spine>::allocationSize() + _blocks->capacity() * sizeof(CowRef<Block>);
+        const size_t shared = other._blocks ? other._blocks->size() : 0;
+        for (size_t b = 0; b < _blocks->size(); b++) {
+            if (b >= shared || (*_blocks)[b] != (*other._blocks)[b]) bytes += CowRef<Block>::allocationSize();
+        }
+        return bytes;
+    }
+
+    const T& operator[](size_t i) const { return (*_blocks)[i / B]->items[i % B]; }
+    const T& back() const { return (*this)[_size - 1]; }
+    /*! Mutable access, cloning shared storage first. */
+    T& edit(size_t i) { return ownBlock(i / B).items[i % B]; }
+    T& editBack() { return edit(_size - 1); }
+
+    void push_back(const T& v) {
+        ownSpine();
+        if (_size / B == _blocks->size()) _blocks->push_back(CowRef<Block>::make());
+        edit(_size++) = v;
+    }
+    void pop_back() { _size--; }
+    /*! Shrinks to n elements, or grows with default constructed ones. Blocks past the end are kept for reuse. */
+    void resize(size_t n) {
+        while (_size < n) push_back(T());
+        _size = n;
+    }
+    void clear() { _size = 0; }
+    void assign(size_t n, const T& v) {
+        clear();
+        for (size_t i = 0; i < n; i++) push_back(v);
+    }
+    /*! Allocates blocks for n elements up front. */
+    void reserve(size_t n) {
+        ownSpine();
+        _blocks->reserve((n + B - 1) / B);
+        while (_blocks->size() * B < n) _blocks->push_back(CowRef<Block>::make());
+    }
+
+   private:
+    using Spine = std::vector<CowRef<Block>>;
+
+    void ownSpine() {
+        if (!_blocks) {
+            _blocks = CowRef<Spine>::make();
+        } else if (!_blocks.unique()) {
+            _blocks = CowRef<Spine>::make(*_blocks);
+        }
+    }
+    Block& ownBlock(size_t b) {
+        if (!_blocks.unique() || !(*_blocks)[b].unique()) {
+            ownSpine();
+            auto& block = (*_blocks)[b];
+            if (!block.unique()) block = CowRef<Block>::make(*block);
+        }
+        return *(*_blocks)[b];
+    }
+
+    CowRef<Spine> _blocks;
+    size_t _size;
+};
+
+}  // namespace util
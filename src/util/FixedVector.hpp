@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*!
+ * The subset of std::vector's interface the simulation uses, backed by inline
+ * storage for at most N elements. Growing past N throws std::length_error.
+ */
+template <typename T, size_t N>
+class FixedVector final {
+   public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    FixedVector() : _size(0) {}
+    explicit FixedVector(size_t n) : FixedVector() { resize(n); }
+    FixedVector(size_t n, const T& value) : FixedVector() { assign(n, value); }
+    template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    FixedVector(It first, It last) : FixedVector() {
+        for (; first != last; ++first) push_back(*first);
+    }
+    FixedVector(const FixedVector& other) : FixedVector() {
+        for (const auto& v : other) push_back(v);
+    }
+    FixedVector(FixedVector&& other) : FixedVector() {
+        for (auto& v : other) push_back(std::move(v));
+    }
+    FixedVector& operator=(const FixedVector& other) {
+        if (this != &other) {
+            clear();
+            for (const auto& v : other) push_back(v);
+        }
+        return *this;
+    }
+    FixedVector& operator=(FixedVector&& other) {
+        if (this != &other) {
+            clear();
+            for (auto& v : other) push_back(std::move(v));
+        }
+        return *this;
+    }
+    ~FixedVector() { clear(); }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    static constexpr size_t capacity() { return N; }
+    void reserve(size_t n) {
+        if (n > N) throw std::length_error("FixedVector capacity exceeded");
+    }
+
+    T* data() { return reinterpret_cast<T*>(_data); }
+    const T* data() const { return reinterpret_cast<const T*>(_data); }
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    T& back() { return data()[_size - 1]; }
+    const T& back() const { return data()[_size - 1]; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + _size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + _size; }
+
+    void push_back(const T& v) { emplace_back(v); }
+    void push_back(T&& v) { emplace_back(std::move(v)); }
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        reserve(_size + 1);
+        T* p = new (data() + _size) T(std::forward<Args>(args)...);
+        _size++;
+        return *p;
+    }
+    void pop_back() { data()[--_size].~T(); }
+    void clear() {
+        while (_size > 0) pop_back();
+    }
+    void resize(size_t n) {
+        while (_size > n) pop_back();
+        while (_size < n) emplace_back();
+    }
+    void resize(size_t n, const T& value) {
+        while (_size > n) pop_back();
+        while (_size < n) push_back(value);
+    }
+    void assign(size_t n, const T& value) {
+        clear();
+        resize(n, value);
+    }
+    iterator erase(iterator pos) {
+        for (iterator it = pos; it + 1 != end(); ++it) *it = std::move(*(it + 1));
+        pop_back();
+        return pos;
+    }
+
+   private:
+    alignas(T) unsigned char _data[N * sizeof(T)];
+    size_t _size;
+};
+
+/*! std::vector when N is 0, a FixedVector holding up to N elements otherwise. */
+template <typename T, size_t N>
+using SmallVector = std::conditional_t<N == 0, std::vector<T>, FixedVector<T, N>>;
+
+/*! Bytes v has allocated on the heap, leaving out what the allocator adds. */
+template <typename T, typename A>
+size_t heapBytes(const std::vector<T, A>& v) {
+    return v.capacity() * sizeof(T);
+}
+/*! Nothing, a FixedVector keeps everything inline. */
+template <typename T, size_t N>
+size_t heapBytes(const FixedVector<T, N>&) {
+    return 0;
+}
+
+}  // namespace util
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace util {
+
+/*!
+ * A whole file mapped read only into memory, at a page aligned address.
+ * Where there's no mmap the file is read into an 8 byte aligned buffer
+ * instead. Throws std::runtime_error if the file can't be opened or mapped.
+ */
+class MappedFile final {
+   public:
+    explicit MappedFile(const std::string& path) : _data(nullptr), _size(0), _copy() {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Can't open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Can't stat " + path);
+        }
+        _size = st.st_size;
+        if (_size > 0) {
+            void* p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Can't map " + path);
+            }
+            _data = p;
+        }
+        // the mapping keeps the file alive on its own
+        ::close(fd);
+#else
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) throw std::runtime_error("Can't open " + path);
+        std::fseek(f, 0, SEEK_END);
+        _size = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        _copy.resize((_size + 7) / 8);
+        const bool ok = std::fread(_copy.data(), 1, _size, f) == _size;
+        std::fclose(f);
+        if (!ok) throw std::runtime_error("Can't read " + path);
+        _data = _copy.data();
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+#ifndef _WIN32
+        if (_data) ::munmap(_data, _size);
+#endif
+    }
+
+    const void* data() const { return _data; }
+    size_t size() const { return _size; }
+
+   private:
+    void* _data;
+    size_t _size;
+    // the file's contents where it couldn't be mapped
+    std::vector<uint64_t> _copy;
+};
+
+}  // namespace util
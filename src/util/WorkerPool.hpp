@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*!
+ * A fixed set of threads running jobs in the order they're submitted. Meant
+ * to be created once and shared, starting a thread costs far more than the
+ * small jobs it runs. Destroying the pool finishes every job already queued.
+ */
+class WorkerPool final {
+   public:
+    /*! Starts threads workers, or one less than the machine has cores if threads isn't positive. */
+    explicit WorkerPool(int threads = 0) : _threads(), _jobs(), _mutex(), _wake(), _stopping(false) {
+        if (threads <= 0) threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+        for (int i = 0; i < threads; i++) _threads.emplace_back([this]() { work(); });
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto& t : _threads) t.join();
+    }
+
+    /*! Queues f, the future becomes ready once it has run and rethrows anything it threw. */
+    template <typename F>
+    std::future<void> submit(F&& f) {
+        // std::function needs something copyable
+        auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+        std::future<void> done = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.emplace_back([task]() { (*task)(); });
+        }
+        _wake.notify_one();
+        return done;
+    }
+    /*!
+     * Runs f(i, worker) for every i below n and waits for all of them. Each
+     * of the pool's threads takes the next i as soon as it's done with one,
+     * so uneven items still keep every thread busy, and worker, which is below
+     * threads(), tells which thread is running it, for keeping results apart
+     * until they're merged. Rethrows the first thing f threw, after waiting
+     * for the rest.
+     */
+    template <typename F>
+    void forEach(size_t n, F&& f) {
+        std::atomic<size_t> next(0);
+        std::vector<std::future<void>> done;
+        for (int t = 0; t < threads() && (size_t)t < n; t++) {
+            done.push_back(submit([&f, &next, n, t]() {
+                for (size_t i; (i = next++) < n;) f(i, t);
+            }));
+        }
+        for (auto& d : done) d.wait();
+        for (auto& d : done) d.get();
+    }
+    int threads() const { return (int)_threads.size(); }
+
+   private:
+    void work() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+                if (_jobs.empty()) return;
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> _threads;
+    std::deque<std::function<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stopping;
+};
+
+}  // namespace util
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lcycle/Replay.hpp"
+#include "lcycle/ReplayFile.hpp"
+#include "lcycle/ReplayStats.hpp"
+#include "util/WorkerPool.hpp"
+
+// Plays every replay file in a directory through the simulation on every
+// core, each thread tallying its own lcycle::ReplayStats, and writes the
+// merged death and trail heatmaps, match lengths and survival curves as CSV
+// files into the output directory. Files cut short and matches that stopped
+// with more than one player alive are left out, so they don't pass for whole
+// matches, and counted. Exits with 1 if any file couldn't be read.
+//
+//     lcycles-analyze [-j threads] [-o output directory] [-c cells] [-b frames per bin] <directory>
+
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+
+    int threads = std::max(1, (int)std::thread::hardware_concurrency());
+    int cells = 64, binFrames = 60;
+    std::string out = ".";
+    const char* dir = nullptr;
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-j") == 0 && hasValue) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            out = argv[++i];
+        } else if (std::strcmp(argv[i], "-c") == 0 && hasValue) {
+            cells = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-b") == 0 && hasValue) {
+            binFrames = std::atoi(argv[++i]);
+        } else {
+            dir = argv[i];
+        }
+    }
+    if (!dir) {
+        std::fprintf(stderr, "usage: %s [-j threads] [-o output directory] [-c cells] [-b frames per bin] ", argv[0]);
+        std::fprintf(stderr, "<directory>\n");
+        return 2;
+    }
+
+    std::vector<std::string> paths;
+    try {
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".lcr") paths.push_back(entry.path().string());
+        }
+        fs::create_directories(out);
+    } catch (const fs::filesystem_error& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    try {
+        util::WorkerPool pool(threads);
+        // one per thread, merged once they're all done
+        std::vector<lcycle::ReplayStats> stats(pool.threads(), lcycle::ReplayStats(cells, binFrames));
+        // per thread too, matches left out of the stats
+        std::vector<size_t> truncated(pool.threads()), unfinished(pool.threads());
+        size_t failed = 0;
+        std::mutex printing;
+        auto start = clock::now();
+        pool.forEach(paths.size(), [&](size_t i, int worker) {
+            try {
+                lcycle::withReplay(paths[i], [&](const auto& replay, const lcycle::ReplayFileInfo& info) {
+                    if (info.truncated) {
+                        truncated[worker]++;
+                    } else if (!stats[worker].addIfFinished(replay)) {
+                        unfinished[worker]++;
+                    }
+                });
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(printing);
+                std::printf("%s: error: %s\n", paths[i].c_str(), e.what());
+                failed++;
+            }
+        });
+        for (size_t t = 1; t < stats.size(); t++) {
+            stats[0].merge(stats[t]);
+            truncated[0] += truncated[t];
+            unfinished[0] += unfinished[t];
+        }
+        const double secs = std::chrono::duration<double>(clock::now() - start).count();
+
+        stats[0].writeCsv(out);
+        std::printf("%llu replays, %zu failed, %zu truncated and %zu unfinished left out, ",
+                    (unsigned long long)stats[0].matches(), failed, truncated[0], unfinished[0]);
+        std::printf("%llu ticks in %.2f s on %d threads: %.0f ticks/sec, %.0f replays/hour\n",
+                    (unsigned long long)stats[0].frames(), secs, threads, stats[0].frames() / secs,
+                    stats[0].matches() / secs * 3600);
+        return failed == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
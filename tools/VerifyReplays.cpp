@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lcycle/Replay.hpp"
+#include "lcycle/ReplayCheck.hpp"
+#include "lcycle/ReplayFile.hpp"
+#include "util/WorkerPool.hpp"
+
+// Plays every replay file in a directory through again with nothing but the
+// simulation, on every core, and reports how each match ended and whether it
+// still plays out the way it was recorded. Exits with 1 if any file couldn't
+// be read or didn't match its checksums.
+//
+//     lcycles-verify [-j threads] <directory>
+
+namespace {
+
+struct Result {
+    std::string path;
+    std::string error;
+    std::string winner;
+    lcycle::ReplayCheck check;
+    bool truncated = false;
+    double secs = 0.0;
+};
+
+void verify(const std::string& path, Result& r) {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    r.path = path;
+    try {
+        lcycle::withReplay(path, [&](const auto& replay, const lcycle::ReplayFileInfo& info) {
+            r.check = lcycle::checkReplay(replay, info.checksums);
+            r.truncated = info.truncated;
+            if (r.check.winner >= 0) {
+                r.winner = replay.initial().roster().byId(r.check.winner).name;
+                if (r.winner.empty()) r.winner = "#" + std::to_string(r.check.winner);
+            } else {
+                r.winner = r.check.alive == 0 ? "(draw)" : "(unfinished)";
+            }
+        });
+    } catch (const std::exception& e) {
+        r.error = e.what();
+    }
+    r.secs = std::chrono::duration<double>(clock::now() - start).count();
+}
+
+void print(const Result& r) {
+    if (!r.error.empty()) {
+        std::printf("%s: error: %s\n", r.path.c_str(), r.error.c_str());
+        return;
+    }
+    std::printf("%s: winner %s, %zu ticks, %zu/%zu checksums mismatched", r.path.c_str(), r.winner.c_str(),
+                r.check.frames, r.check.mismatches, r.check.checksums);
+    if (r.check.mismatches > 0) std::printf(" from tick %zu", r.check.firstMismatch);
+    std::printf(", %.0f ticks/sec%s\n", r.check.frames / r.secs, r.truncated ? ", truncated" : "");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+
+    int threads = std::max(1, (int)std::thread::hardware_concurrency());
+    const char* dir = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else {
+            dir = argv[i];
+        }
+    }
+    if (!dir) {
+        std::fprintf(stderr, "usage: %s [-j threads] <directory>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> paths;
+    try {
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".lcr") paths.push_back(entry.path().string());
+        }
+    } catch (const fs::filesystem_error& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Result> results(paths.size());
+    std::mutex printing;
+    auto start = clock::now();
+    {
+        util::WorkerPool pool(threads);
+        pool.forEach(paths.size(), [&](size_t i, int) {
+            verify(paths[i], results[i]);
+            std::lock_guard<std::mutex> lock(printing);
+            print(results[i]);
+        });
+    }
+    const double secs = std::chrono::duration<double>(clock::now() - start).count();
+
+    size_t failed = 0;
+    uint64_t ticks = 0;
+    for (const auto& r : results) {
+        failed += !r.error.empty() || r.check.mismatches > 0;
+        ticks += r.check.frames;
+    }
+    std::printf("%zu replays, %zu failed, %llu ticks in %.2f s on %d threads: %.0f ticks/sec, %.0f replays/hour\n",
+                results.size(), failed, (unsigned long long)ticks, secs, threads, ticks / secs,
+                results.size() / secs * 3600);
+    return failed == 0 ? 0 : 1;
+}